@@ -0,0 +1,248 @@
+/*******************************************************************************
+  This is an interrupt driven sampler for the analog inputs.
+  Each conversion complete interrupt stores the result, switches the
+  multiplexer to the next channel and starts the next conversion, so the ADC
+  runs continuously without any help from the main loop. A new conversion is
+  started by the interrupt rather than by the auto trigger, since a
+  multiplexer change in free running mode only takes effect one conversion
+  late.
+
+  The MIT License (MIT)
+
+  Copyright (c) 2017 Kjell Kernen (Dvogonen)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+********************************************************************************/
+// Application includes
+#include "Arduino.h"
+#include "adcsampler.h"
+#include "profiler.h"
+
+// Library includes
+#ifdef __AVR__
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#endif
+
+//******************************************************************************
+//* File scope variables. Written by the interrupt, read by the main loop.
+
+static uint8_t           adcPins[ADC_CHANNELS];
+static uint8_t           adcFilters[ADC_CHANNELS];
+static uint16_t          adcRing[ADC_CHANNELS][ADC_RING_SIZE];
+static uint8_t           adcIndex[ADC_CHANNELS];
+static uint16_t          adcSum[ADC_CHANNELS];
+static volatile uint16_t adcValue[ADC_CHANNELS];
+static volatile uint8_t  adcCount[ADC_CHANNELS];
+static uint8_t           adcChannel = 0;
+static uint8_t           adcPrescaler = ADC_PRESCALER_64;
+#ifndef __AVR__
+static uint32_t          adcLastConversion = 0;
+#endif
+
+#ifdef __AVR__
+//******************************************************************************
+//* function: adcMux
+//*         : returns the multiplexer setting for an analog pin
+//******************************************************************************
+static uint8_t adcMux( uint8_t pin )
+{
+  if (pin >= 14)
+    pin -= 14;
+  return _BV(REFS0) | (pin & 0x0F);  // AVcc reference, like analogRead()
+}
+#endif
+
+//******************************************************************************
+//* function: adcFilter
+//*         : calculates the filtered value of a channel from its ring buffer
+//*         : runs in interrupt context, so it is kept short
+//******************************************************************************
+static uint16_t adcFilter( uint8_t channel )
+{
+  uint16_t sorted[ADC_RING_SIZE];
+  uint16_t *ring = adcRing[channel];
+  uint16_t lo, hi, v;
+  uint8_t  i, j;
+
+  switch (adcFilters[channel]) {
+    case ADC_FILTER_MEDIAN:
+      // Insertion sort, ADC_RING_SIZE is small
+      for (i = 0; i < ADC_RING_SIZE; i++) {
+        v = ring[i];
+        for (j = i; j && sorted[j - 1] > v; j--)
+          sorted[j] = sorted[j - 1];
+        sorted[j] = v;
+      }
+      return (sorted[ADC_RING_SIZE / 2 - 1] + sorted[ADC_RING_SIZE / 2]) >> 1;
+
+    case ADC_FILTER_TRIMMED:
+      lo = hi = ring[0];
+      for (i = 1; i < ADC_RING_SIZE; i++) {
+        if (ring[i] < lo) lo = ring[i];
+        if (ring[i] > hi) hi = ring[i];
+      }
+      return (adcSum[channel] - lo - hi) / (ADC_RING_SIZE - 2);
+
+    default:
+      return adcSum[channel] / ADC_RING_SIZE;
+  }
+}
+
+//******************************************************************************
+//* function: adcStore
+//*         : stores a conversion result for the current channel and moves on
+//*         : to the next channel
+//******************************************************************************
+static void adcStore( uint16_t sample )
+{
+  uint8_t channel = adcChannel;
+  uint8_t index = adcIndex[channel];
+
+  adcSum[channel] += sample - adcRing[channel][index];
+  adcRing[channel][index] = sample;
+  adcIndex[channel] = (index + 1) % ADC_RING_SIZE;
+  adcValue[channel] = adcFilter(channel);
+  adcCount[channel]++;
+
+  adcChannel = (channel + 1) % ADC_CHANNELS;
+}
+
+#ifdef __AVR__
+//******************************************************************************
+//* function: ADC conversion complete interrupt
+//******************************************************************************
+ISR(ADC_vect)
+{
+  uint16_t sample = ADC;
+
+  PROFILE_BEGIN(PROFILE_ADC_ISR);
+  // Start converting the next channel before the result is processed
+  ADMUX = adcMux(adcPins[(adcChannel + 1) % ADC_CHANNELS]);
+  ADCSRA |= _BV(ADSC);
+  adcStore(sample);
+  PROFILE_END(PROFILE_ADC_ISR);
+}
+#else
+//******************************************************************************
+//* function: adcCatchUp
+//*         : without the ADC interrupt the conversions that would have
+//*         : completed since the last call are made with analogRead()
+//******************************************************************************
+static void adcCatchUp( void )
+{
+  uint32_t now = micros();
+  uint32_t conversion = adcConversionTime();
+  uint8_t  n = 0;
+
+  while ((now - adcLastConversion) >= conversion && n < ADC_CHANNELS * ADC_RING_SIZE) {
+    adcStore(analogRead(adcPins[adcChannel]));
+    adcLastConversion += conversion;
+    n++;
+  }
+  if ((now - adcLastConversion) >= conversion)
+    adcLastConversion = now;
+}
+#endif
+
+//******************************************************************************
+//* function: adcSetChannel
+//*         : assigns an analog pin and a filter to a channel, call before
+//*         : adcBegin
+//******************************************************************************
+void adcSetChannel( uint8_t channel, uint8_t pin, uint8_t filter )
+{
+  adcPins[channel] = pin;
+  adcFilters[channel] = filter;
+}
+
+//******************************************************************************
+//* function: adcBegin
+//*         : fills the ring buffers and starts the conversions
+//******************************************************************************
+void adcBegin( uint8_t prescaler )
+{
+  uint8_t channel;
+  uint8_t i;
+  uint16_t sample;
+
+  adcPrescaler = prescaler;
+
+  // Prime the ring buffers so the first values read are valid
+  for (channel = 0; channel < ADC_CHANNELS; channel++) {
+    sample = analogRead(adcPins[channel]);
+    adcSum[channel] = 0;
+    for (i = 0; i < ADC_RING_SIZE; i++) {
+      adcRing[channel][i] = sample;
+      adcSum[channel] += sample;
+    }
+    adcIndex[channel] = 0;
+    adcValue[channel] = sample;
+  }
+  adcChannel = 0;
+
+#ifdef __AVR__
+  ADMUX = adcMux(adcPins[0]);
+  ADCSRB = 0;
+  ADCSRA = _BV(ADEN) | _BV(ADIE) | _BV(ADSC) | prescaler;
+#else
+  adcLastConversion = micros();
+#endif
+}
+
+//******************************************************************************
+//* function: adcRead
+//*         : returns the latest filtered value of a channel
+//******************************************************************************
+uint16_t adcRead( uint8_t channel )
+{
+  uint16_t value;
+
+#ifdef __AVR__
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    value = adcValue[channel];
+  }
+#else
+  adcCatchUp();
+  value = adcValue[channel];
+#endif
+  return value;
+}
+
+//******************************************************************************
+//* function: adcSampleCount
+//*         : returns a counter that is incremented for each new sample of a
+//*         : channel. The counter wraps, use differences.
+//******************************************************************************
+uint8_t adcSampleCount( uint8_t channel )
+{
+#ifndef __AVR__
+  adcCatchUp();
+#endif
+  return adcCount[channel];
+}
+
+//******************************************************************************
+//* function: adcConversionTime
+//*         : returns the time of one conversion in microseconds
+//******************************************************************************
+uint32_t adcConversionTime( void )
+{
+  return (13UL << adcPrescaler) * 1000000UL / F_CPU;
+}
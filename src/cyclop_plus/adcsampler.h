@@ -0,0 +1,56 @@
+/*******************************************************************************
+  This is the header file for an interrupt driven sampler for the analog
+  inputs. The ADC converts the configured channels in turn and stores the
+  results in a small ring buffer per channel. A filtered value is kept up to
+  date for every channel, so reading it is a plain variable access.
+
+  The MIT License (MIT)
+
+  Copyright (c) 2017 Kjell Kernen (Dvogonen)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+********************************************************************************/
+#ifndef adcsampler_h
+#define adcsampler_h
+
+#include "Arduino.h"
+
+// Number of channels and samples kept per channel
+#define ADC_CHANNELS          2
+#define ADC_RING_SIZE         8
+
+// Filters applied to the ring buffer of a channel
+#define ADC_FILTER_MEAN       0
+#define ADC_FILTER_MEDIAN     1   // mean of the two middle samples
+#define ADC_FILTER_TRIMMED    2   // mean without the lowest and highest sample
+
+// ADC clock prescalers. The ADC needs a clock between 50 and 200 kHz for full
+// resolution. A conversion takes 13 ADC clocks.
+#define ADC_PRESCALER_16      4
+#define ADC_PRESCALER_32      5
+#define ADC_PRESCALER_64      6
+#define ADC_PRESCALER_128     7
+
+void     adcSetChannel( uint8_t channel, uint8_t pin, uint8_t filter );
+void     adcBegin( uint8_t prescaler );
+uint16_t adcRead( uint8_t channel );
+uint8_t  adcSampleCount( uint8_t channel );
+uint32_t adcConversionTime( void );
+
+#endif // adcsampler_h
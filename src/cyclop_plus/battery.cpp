@@ -0,0 +1,137 @@
+/*******************************************************************************
+  This is the battery model. The sampler averages the battery input in the
+  background, the battery task hands the result to batteryUpdate() and the
+  screens read the cached level. The level comes from the discharge curve of a
+  LiPo cell under the load of the goggles, so it does not jump when the
+  voltage sags.
+
+  The MIT License (MIT)
+
+  Copyright (c) 2017 Kjell Kernen (Dvogonen)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+********************************************************************************/
+// Application includes
+#include "Arduino.h"
+#include "battery.h"
+
+//******************************************************************************
+//* Discharge curve of a resting LiPo cell in millivolts, at 0, 10 .. 100 %
+
+static const uint16_t cellCurve[] PROGMEM = {
+  3400, 3610, 3690, 3750, 3790, 3830, 3870, 3920, 3980, 4060, 4200
+};
+
+#define CURVE_POINTS  (sizeof(cellCurve) / sizeof(cellCurve[0]))
+
+// Alarm stage entry levels, by stage
+static const uint8_t alarmLevels[] PROGMEM = {
+  100, BATTERY_LOW_LEVEL, BATTERY_LOWER_LEVEL, BATTERY_EMPTY_LEVEL
+};
+
+//******************************************************************************
+//* File scope variables
+
+static uint16_t batteryAverage = 0;      // ADC value << BATTERY_AVERAGE_SHIFT
+static uint16_t batteryMv = 0;
+static uint8_t  batteryPercent = 99;
+static uint8_t  batteryStage = BATTERY_ALARM_NONE;
+
+//******************************************************************************
+//* function: cellLevel
+//*         : interpolates the charge level in percent of a cell voltage
+//******************************************************************************
+static uint8_t cellLevel( uint16_t millivolts )
+{
+  uint16_t low, high;
+  uint8_t  i;
+
+  if (millivolts <= pgm_read_word(cellCurve))
+    return 0;
+  for (i = 1; i < CURVE_POINTS; i++) {
+    high = pgm_read_word(cellCurve + i);
+    if (millivolts < high) {
+      low = pgm_read_word(cellCurve + i - 1);
+      return (i - 1) * 10 + (millivolts - low) * 10 / (high - low);
+    }
+  }
+  return 100;
+}
+
+//******************************************************************************
+//* function: batteryUpdate
+//*         : adds an ADC sample of the battery input to the average and
+//*         : updates the voltage, the level and the alarm stage
+//******************************************************************************
+void batteryUpdate( uint16_t adc, uint8_t calibration, uint8_t cells )
+{
+  int16_t  millivolts;
+  uint16_t cell;
+  uint8_t  stage;
+
+  if (!batteryAverage)
+    batteryAverage = adc << BATTERY_AVERAGE_SHIFT;
+  else
+    batteryAverage += adc - (batteryAverage >> BATTERY_AVERAGE_SHIFT);
+
+  millivolts = BATTERY_MV_OFFSET + ((int16_t)(batteryAverage >> BATTERY_AVERAGE_SHIFT) - BATTERY_ADC_OFFSET +
+               (int16_t)calibration - BATTERY_CALIB_CENTER) * BATTERY_MV_PER_STEP;
+  batteryMv = millivolts > 0 ? millivolts : 0;
+
+  cell = batteryMv / cells + (cells == 2 ? BATTERY_SAG_2S_MV : BATTERY_SAG_3S_MV);
+  batteryPercent = cellLevel(cell);
+  if (batteryPercent > 99)
+    batteryPercent = 99;
+
+  // Raise the stage at once, lower it one step at a time once the level is
+  // clear of the entry level of the stage
+  stage = batteryStage;
+  while (stage < BATTERY_ALARM_EMPTY && batteryPercent < pgm_read_byte(alarmLevels + stage + 1))
+    stage++;
+  while (stage > BATTERY_ALARM_NONE && batteryPercent >= pgm_read_byte(alarmLevels + stage) + BATTERY_ALARM_HYSTERESIS)
+    stage--;
+  batteryStage = stage;
+}
+
+//******************************************************************************
+//* function: batteryMillivolts
+//*         : the averaged voltage of the pack
+//******************************************************************************
+uint16_t batteryMillivolts( void )
+{
+  return batteryMv;
+}
+
+//******************************************************************************
+//* function: batteryLevel
+//*         : the charge level of the pack, 0 to 99 %
+//******************************************************************************
+uint8_t batteryLevel( void )
+{
+  return batteryPercent;
+}
+
+//******************************************************************************
+//* function: batteryAlarm
+//*         : the alarm stage, BATTERY_ALARM_NONE to BATTERY_ALARM_EMPTY
+//******************************************************************************
+uint8_t batteryAlarm( void )
+{
+  return batteryStage;
+}
@@ -0,0 +1,66 @@
+/*******************************************************************************
+  This is the header file for the battery model. It filters the battery
+  voltage that the ADC sampler measures in the background and converts it to
+  a charge level and an alarm stage that the screens and the alarm read.
+
+  The MIT License (MIT)
+
+  Copyright (c) 2017 Kjell Kernen (Dvogonen)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+********************************************************************************/
+#ifndef battery_h
+#define battery_h
+
+#include "Arduino.h"
+
+// Weight of a new sample in the average, as a right shift (1/8). With a
+// sample every BATTERY_SAMPLE_MS that is a time constant of about 4 seconds.
+#define BATTERY_SAMPLE_MS       500
+#define BATTERY_AVERAGE_SHIFT   3
+
+// Conversion of the ADC value to millivolts, 20 mV per step with 5 V at 250.
+// Calibration moves the voltage by a step per unit away from 128.
+#define BATTERY_ADC_OFFSET      250
+#define BATTERY_MV_OFFSET       5000
+#define BATTERY_MV_PER_STEP     20
+#define BATTERY_CALIB_CENTER    128
+
+// Voltage drop of a cell while the goggles run. A 2S pack carries half again
+// the current of a 3S pack, and drops more per cell.
+#define BATTERY_SAG_2S_MV       45
+#define BATTERY_SAG_3S_MV       30
+
+// Alarm stages, raised below the levels in percent and lowered again when
+// the level is BATTERY_ALARM_HYSTERESIS above them
+#define BATTERY_ALARM_NONE      0
+#define BATTERY_ALARM_LOW       1
+#define BATTERY_ALARM_LOWER     2
+#define BATTERY_ALARM_EMPTY     3
+#define BATTERY_LOW_LEVEL       25
+#define BATTERY_LOWER_LEVEL     15
+#define BATTERY_EMPTY_LEVEL     5
+#define BATTERY_ALARM_HYSTERESIS 3
+
+void     batteryUpdate( uint16_t adc, uint8_t calibration, uint8_t cells );
+uint16_t batteryMillivolts( void );
+uint8_t  batteryLevel( void );
+uint8_t  batteryAlarm( void );
+
+#endif // battery_h
@@ -0,0 +1,318 @@
+/*******************************************************************************
+  This file contains the button. Timer 2 samples the pin every millisecond,
+  debounces it and queues a time stamped event for each accepted press and
+  release. The queue has a single producer, the interrupt, and a single
+  consumer, the main loop, so it needs no locking. The main loop classifies
+  the events into single, double and long clicks by their time stamps, so a
+  click is told apart correctly even when the loop picks it up late.
+
+  The MIT License (MIT)
+
+  Copyright (c) 2017 Kjell Kernen (Dvogonen)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+********************************************************************************/
+// Application includes
+#include "Arduino.h"
+#include "button.h"
+#include "profiler.h"
+
+// Library includes
+#ifdef __AVR__
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#else
+#include "hosttimer.h"
+#endif
+
+// Click classifier states
+#define CLICK_IDLE            0   // released
+#define CLICK_PRESSED         1   // pressed, not long yet
+#define CLICK_WAIT            2   // released, a second press makes a double click
+#define CLICK_SECOND          3   // second press of a double click
+#define CLICK_HELD            4   // long click reported, waits for the release
+
+//******************************************************************************
+//* File scope variables. The interrupt owns the head and the debouncer, the
+//* main loop the tail and the classifier.
+
+static volatile uint8_t  eventType[BUTTON_EVENTS];
+static volatile uint16_t eventTime[BUTTON_EVENTS];
+static volatile uint8_t  eventHead = 0;
+static volatile uint8_t  eventTail = 0;
+static volatile uint8_t  eventLost = 0;
+static volatile uint16_t buttonTicks = 0;
+static volatile uint8_t  buttonStable = 0;    // debounced level, 1 is pressed
+static uint8_t           buttonChange = 0;    // ms the pin has differed from it
+static uint8_t           buttonPin;
+static uint8_t           buttonPressed;
+#ifdef __AVR__
+static volatile uint8_t *buttonPort;
+static uint8_t           buttonMask;
+#endif
+
+static uint8_t           clickState = CLICK_IDLE;
+static uint16_t          clickEdge = 0;       // time of the edge that entered the state
+static bool              clickInstant = false;
+static uint16_t          clickLatency = 0;
+
+//******************************************************************************
+//* function: buttonSample
+//*         : called every millisecond from the timer interrupt. An edge is
+//*         : accepted when the pin has kept its new level for
+//*         : BUTTON_DEBOUNCE_MS, and is stamped with the time of the first
+//*         : sample at that level.
+//******************************************************************************
+static void buttonSample( void )
+{
+  uint8_t level;
+  uint8_t head;
+
+  buttonTicks++;
+#ifdef __AVR__
+  level = (*buttonPort & buttonMask) ? HIGH : LOW;
+#else
+  level = digitalRead(buttonPin);
+#endif
+  level = level == buttonPressed;
+  if (level == buttonStable) {
+    buttonChange = 0;
+    return;
+  }
+  if (++buttonChange < BUTTON_DEBOUNCE_MS)
+    return;
+
+  PROFILE_BEGIN(PROFILE_BUTTON_ISR);
+  buttonChange = 0;
+  buttonStable = level;
+  head = eventHead;
+  if ((uint8_t)(head - eventTail) < BUTTON_EVENTS) {
+    eventType[head % BUTTON_EVENTS] = level ? BUTTON_PRESS : BUTTON_RELEASE;
+    eventTime[head % BUTTON_EVENTS] = buttonTicks - (BUTTON_DEBOUNCE_MS - 1);
+    eventHead = head + 1;
+  }
+  else
+    eventLost = 1;
+  PROFILE_END(PROFILE_BUTTON_ISR);
+}
+
+#ifdef __AVR__
+//******************************************************************************
+//* function: ISR(TIMER2_COMPA_vect)
+//******************************************************************************
+ISR(TIMER2_COMPA_vect)
+{
+  buttonSample();
+}
+#endif
+
+//******************************************************************************
+//* function: buttonNow
+//*         : returns the millisecond count of the timer interrupt
+//******************************************************************************
+static uint16_t buttonNow( void )
+{
+  uint16_t now;
+
+#ifdef __AVR__
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    now = buttonTicks;
+  }
+#else
+  now = buttonTicks;
+#endif
+  return now;
+}
+
+//******************************************************************************
+//* function: buttonEvent
+//*         : feeds a press or release to the classifier. Returns a click
+//*         : when the event completes one, and the time of the edge that
+//*         : completed it in last.
+//******************************************************************************
+static uint8_t buttonEvent( uint8_t type, uint16_t time, uint16_t *last )
+{
+  switch (clickState) {
+    case CLICK_IDLE:
+      if (type == BUTTON_PRESS) {
+        clickState = CLICK_PRESSED;
+        clickEdge = time;
+      }
+      break;
+
+    case CLICK_PRESSED:
+      if (type != BUTTON_RELEASE)
+        break;
+      // A long press whose release is read after the fact
+      if ((uint16_t)(time - clickEdge) >= BUTTON_LONG_MS) {
+        *last = clickEdge + BUTTON_LONG_MS;
+        clickState = CLICK_IDLE;
+        return LONG_CLICK;
+      }
+      if (clickInstant) {
+        *last = time;
+        clickState = CLICK_IDLE;
+        return SINGLE_CLICK;
+      }
+      clickState = CLICK_WAIT;
+      clickEdge = time;
+      break;
+
+    case CLICK_WAIT:
+      if (type != BUTTON_PRESS)
+        break;
+      if ((uint16_t)(time - clickEdge) < BUTTON_DOUBLE_MS) {
+        clickState = CLICK_SECOND;
+        break;
+      }
+      // Too late for a double click, the press starts the next click
+      *last = clickEdge;
+      clickState = CLICK_PRESSED;
+      clickEdge = time;
+      return SINGLE_CLICK;
+
+    case CLICK_SECOND:
+      if (type == BUTTON_RELEASE) {
+        *last = time;
+        clickState = CLICK_IDLE;
+        return DOUBLE_CLICK;
+      }
+      break;
+
+    case CLICK_HELD:
+      if (type == BUTTON_RELEASE)
+        clickState = CLICK_IDLE;
+      break;
+  }
+  return NO_CLICK;
+}
+
+//******************************************************************************
+//* function: buttonTimeout
+//*         : completes the clicks that are decided by the time that has
+//*         : passed without an event
+//******************************************************************************
+static uint8_t buttonTimeout( uint16_t now, uint16_t *last )
+{
+  switch (clickState) {
+    case CLICK_PRESSED:
+      if ((uint16_t)(now - clickEdge) >= BUTTON_LONG_MS) {
+        *last = clickEdge + BUTTON_LONG_MS;
+        clickState = CLICK_HELD;
+        return LONG_CLICK;
+      }
+      break;
+
+    case CLICK_WAIT:
+      if (clickInstant || (uint16_t)(now - clickEdge) >= BUTTON_DOUBLE_MS) {
+        *last = clickEdge;
+        clickState = CLICK_IDLE;
+        return SINGLE_CLICK;
+      }
+      break;
+  }
+  return NO_CLICK;
+}
+
+//******************************************************************************
+//* function: buttonBegin
+//*         : starts sampling a pin that reads pressed when pressed. A button
+//*         : that is held already is ignored until it has been released.
+//******************************************************************************
+void buttonBegin( uint8_t pin, uint8_t pressed )
+{
+  buttonPin = pin;
+  buttonPressed = pressed;
+  buttonStable = digitalRead(pin) == pressed;
+  clickState = buttonStable ? CLICK_HELD : CLICK_IDLE;
+
+#ifdef __AVR__
+  buttonPort = portInputRegister(digitalPinToPort(pin));
+  buttonMask = digitalPinToBitMask(pin);
+
+  // Timer 2 in CTC mode on clock/64, a compare match every millisecond
+  TCCR2A = _BV(WGM21);
+  TCCR2B = _BV(CS22);
+  OCR2A = F_CPU / 64 / 1000 - 1;
+  TCNT2 = 0;
+  TIMSK2 = _BV(OCIE2A);
+#else
+  hostTimerAttach(buttonSample, 1000);
+#endif
+}
+
+//******************************************************************************
+//* function: buttonDown
+//*         : returns true while the debounced button is pressed
+//******************************************************************************
+bool buttonDown( void )
+{
+  return buttonStable;
+}
+
+//******************************************************************************
+//* function: buttonClick
+//*         : returns the next click, or NO_CLICK. Queued events are
+//*         : classified first, in the order they happened.
+//******************************************************************************
+uint8_t buttonClick( void )
+{
+  uint8_t  click = NO_CLICK;
+  uint16_t last = 0;
+  uint8_t  tail;
+
+  while (click == NO_CLICK && (tail = eventTail) != eventHead) {
+    click = buttonEvent(eventType[tail % BUTTON_EVENTS], eventTime[tail % BUTTON_EVENTS], &last);
+    eventTail = tail + 1;
+  }
+  if (click == NO_CLICK) {
+    // Edges were dropped while the queue was full, start over from the
+    // current level
+    if (eventLost) {
+      eventLost = 0;
+      clickState = buttonStable ? CLICK_HELD : CLICK_IDLE;
+    }
+    click = buttonTimeout(buttonNow(), &last);
+  }
+  if (click != NO_CLICK)
+    clickLatency = buttonNow() - last;
+  return click;
+}
+
+//******************************************************************************
+//* function: buttonInstant
+//*         : in instant mode a release is a single click at once, there are
+//*         : no double clicks. Use it where a double click has no meaning.
+//******************************************************************************
+void buttonInstant( bool instant )
+{
+  clickInstant = instant;
+}
+
+//******************************************************************************
+//* function: buttonLatency
+//*         : milliseconds from the edge that completed the last click, or
+//*         : for a long click from the moment it became long, until
+//*         : buttonClick() returned it. A single click outside instant mode
+//*         : includes the BUTTON_DOUBLE_MS wait for a second press.
+//******************************************************************************
+uint16_t buttonLatency( void )
+{
+  return clickLatency;
+}
@@ -0,0 +1,57 @@
+/*******************************************************************************
+  This is the header file for the button. A timer interrupt samples and
+  debounces the button pin every millisecond and queues time stamped press
+  and release events. The main loop turns the events into clicks.
+
+  The MIT License (MIT)
+
+  Copyright (c) 2017 Kjell Kernen (Dvogonen)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+********************************************************************************/
+#ifndef button_h
+#define button_h
+
+#include "Arduino.h"
+#include "cyclop_plus.h"
+
+// The pin is sampled every millisecond and has to be stable this long
+// before an edge is accepted
+#define BUTTON_DEBOUNCE_MS      5
+
+// A press longer than this is a long click, it is reported while the
+// button is still held. A second press sooner than BUTTON_DOUBLE_MS after
+// the release of the first makes a double click.
+#define BUTTON_LONG_MS          350
+#define BUTTON_DOUBLE_MS        350
+
+// Number of events that can wait for the main loop, a power of two
+#define BUTTON_EVENTS           8
+
+// Event types
+#define BUTTON_RELEASE          0
+#define BUTTON_PRESS            1
+
+void     buttonBegin( uint8_t pin, uint8_t pressed );
+bool     buttonDown( void );
+uint8_t  buttonClick( void );
+void     buttonInstant( bool instant );
+uint16_t buttonLatency( void );
+
+#endif // button_h
@@ -0,0 +1,280 @@
+/*******************************************************************************
+  This file contains the channel model. The PROGMEM tables are generated at
+  compile time from BAND_PLAN in channels.h. Only the next and previous tables
+  depend on the enabled bands and are rebuilt in RAM when the options change,
+  so stepping and nearest channel lookup are constant time.
+
+  The MIT License (MIT)
+
+  Copyright (c) 2017 Kjell Kernen (Dvogonen)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+********************************************************************************/
+// Application includes
+#include "Arduino.h"
+#include "channels.h"
+#include "spectrum.h"
+
+static_assert(BAND_COUNT <= 8, "The band enables must fit in a byte");
+
+//******************************************************************************
+//* Compile time helpers
+//* Raw index: position of a frequency in the band plan, band * 8 + channel.
+//* Channel:   position in frequency order, equal frequencies in raw order.
+
+#define BAND_FREQUENCIES(letter, name, f1, f2, f3, f4, f5, f6, f7, f8) \
+  f1, f2, f3, f4, f5, f6, f7, f8,
+
+constexpr uint16_t bandPlan[] = { BAND_PLAN(BAND_FREQUENCIES) };
+
+constexpr uint16_t lower( uint16_t a, uint16_t b ) {
+  return a < b ? a : b;
+}
+
+constexpr uint16_t higher( uint16_t a, uint16_t b ) {
+  return a > b ? a : b;
+}
+
+constexpr uint16_t planMin( uint8_t raw = 0 ) {
+  return raw + 1 >= CHANNEL_COUNT ? bandPlan[raw] : lower(bandPlan[raw], planMin(raw + 1));
+}
+
+constexpr uint16_t planMax( uint8_t raw = 0 ) {
+  return raw + 1 >= CHANNEL_COUNT ? bandPlan[raw] : higher(bandPlan[raw], planMax(raw + 1));
+}
+
+// Number of raw entries sorted before raw entry 'raw'
+constexpr uint8_t channelOfRaw( uint8_t raw, uint8_t other = 0 ) {
+  return other >= CHANNEL_COUNT ? 0 :
+         (bandPlan[other] < bandPlan[raw] || (bandPlan[other] == bandPlan[raw] && other < raw)) +
+         channelOfRaw(raw, other + 1);
+}
+
+constexpr uint8_t rawOfChannel( uint8_t channel, uint8_t raw = 0 ) {
+  return channelOfRaw(raw) == channel ? raw : rawOfChannel(channel, raw + 1);
+}
+
+// Number of channels below a frequency, i.e. the first channel at or above it
+constexpr uint8_t channelsBelow( uint16_t frequency, uint8_t raw = 0 ) {
+  return raw >= CHANNEL_COUNT ? 0 : (bandPlan[raw] < frequency) + channelsBelow(frequency, raw + 1);
+}
+
+// The nearest channel search starts from a bucket of BUCKET_WIDTH MHz
+#define BUCKET_WIDTH  8
+#define BUCKET_BASE   planMin()
+#define BUCKET_COUNT  ((planMax() - planMin()) / BUCKET_WIDTH + 1)
+
+//******************************************************************************
+//* Table generation
+//* The index lists expand to one initializer per entry, evaluated by the
+//* compiler. Nothing of bandPlan itself ends up in the binary.
+
+template <uint8_t... I> struct indexList {};
+template <uint8_t N, uint8_t... I> struct makeIndexList : makeIndexList<N - 1, N - 1, I...> {};
+template <uint8_t... I> struct makeIndexList<0, I...> {
+  typedef indexList<I...> type;
+};
+
+template <typename List> struct channelTables;
+template <uint8_t... I> struct channelTables< indexList<I...> > {
+  static const uint8_t  raw[];        // Raw index of each channel
+  static const uint16_t frequency[];  // Frequency of each channel
+};
+template <uint8_t... I> const uint8_t  channelTables< indexList<I...> >::raw[] PROGMEM = { rawOfChannel(I)... };
+template <uint8_t... I> const uint16_t channelTables< indexList<I...> >::frequency[] PROGMEM = { bandPlan[rawOfChannel(I)]... };
+
+template <typename List> struct bucketTable;
+template <uint8_t... I> struct bucketTable< indexList<I...> > {
+  static const uint8_t first[];       // First channel at or above each bucket
+};
+template <uint8_t... I> const uint8_t bucketTable< indexList<I...> >::first[] PROGMEM = { channelsBelow(BUCKET_BASE + I * BUCKET_WIDTH)... };
+
+typedef channelTables< makeIndexList<CHANNEL_COUNT>::type > tables;
+typedef bucketTable< makeIndexList<BUCKET_COUNT>::type > buckets;
+
+#define BAND_LETTER(letter, name, ...) letter,
+#define BAND_NAME(letter, name, ...)   name,
+
+static const char bandLetters[] PROGMEM = { BAND_PLAN(BAND_LETTER) };
+static const char bandNames[][BAND_NAME_SIZE] PROGMEM = { BAND_PLAN(BAND_NAME) };
+
+//******************************************************************************
+//* File scope variables
+
+static uint8_t channelBands = BAND_ALL;
+static uint8_t nextTable[CHANNEL_COUNT];
+static uint8_t previousTable[CHANNEL_COUNT];
+
+//******************************************************************************
+//* function: channelSetBands
+//*         : sets the bands available for stepping, bit n enables band n of
+//*         : the band plan. At least one band is always kept enabled.
+//******************************************************************************
+void channelSetBands( uint8_t bands )
+{
+  uint8_t pass;
+  uint8_t i;
+  uint8_t last;
+
+  bands &= BAND_ALL;
+  if (!bands)
+    bands = BAND_ALL;
+  channelBands = bands;
+
+  // The first pass only finds the channel to wrap around to
+  last = 0;
+  for (pass = 0; pass < 2; pass++) {
+    for (i = CHANNEL_COUNT; i-- > 0;) {
+      nextTable[i] = last;
+      if (bands & (1 << channelBand(i)))
+        last = i;
+    }
+  }
+  for (pass = 0; pass < 2; pass++) {
+    for (i = 0; i < CHANNEL_COUNT; i++) {
+      previousTable[i] = last;
+      if (bands & (1 << channelBand(i)))
+        last = i;
+    }
+  }
+}
+
+//******************************************************************************
+//* function: channelFirst
+//*         : returns the lowest enabled channel
+//******************************************************************************
+uint8_t channelFirst( void )
+{
+  return nextTable[CHANNEL_COUNT - 1];
+}
+
+//******************************************************************************
+//* function: channelNext
+//*         : returns the next enabled channel in frequency order, wraps around
+//******************************************************************************
+uint8_t channelNext( uint8_t channel )
+{
+  if (channel >= CHANNEL_COUNT)
+    channel = CHANNEL_COUNT - 1;
+  return nextTable[channel];
+}
+
+//******************************************************************************
+//* function: channelPrevious
+//*         : returns the previous enabled channel in frequency order
+//******************************************************************************
+uint8_t channelPrevious( uint8_t channel )
+{
+  if (channel >= CHANNEL_COUNT)
+    channel = 0;
+  return previousTable[channel];
+}
+
+//******************************************************************************
+//* function: channelNearest
+//*         : finds the channel closest to a frequency. All bands are
+//*         : considered, the band enables only affect stepping. When the
+//*         : frequency is about as close to two channels, the average RSSI
+//*         : the spectrum store has for them decides.
+//******************************************************************************
+uint8_t channelNearest( uint16_t frequency )
+{
+  uint16_t bucket;
+  uint16_t below, above;
+  uint16_t rssiBelow, rssiAbove;
+  uint8_t  channel;
+  bool     lower;
+
+  if (frequency <= BUCKET_BASE)
+    return 0;
+  bucket = (frequency - BUCKET_BASE) / BUCKET_WIDTH;
+  if (bucket >= BUCKET_COUNT)
+    return CHANNEL_COUNT - 1;
+
+  // Skip the few channels in the bucket that are below the frequency
+  channel = pgm_read_byte(buckets::first + bucket);
+  while (channel < CHANNEL_COUNT && channelFrequency(channel) < frequency)
+    channel++;
+
+  if (channel == CHANNEL_COUNT)
+    lower = true;
+  else if (channel == 0)
+    lower = false;
+  else {
+    below = frequency - channelFrequency(channel - 1);
+    above = channelFrequency(channel) - frequency;
+    rssiBelow = spectrumRssi(channelFrequency(channel - 1));
+    rssiAbove = spectrumRssi(channelFrequency(channel));
+    if (below <= above + CHANNEL_NEAR_MHZ && above <= below + CHANNEL_NEAR_MHZ && rssiBelow != rssiAbove)
+      lower = rssiBelow > rssiAbove;
+    else
+      lower = below <= above;       // Ties go to the lower channel
+  }
+  if (lower) {
+    channel--;
+    while (channel > 0 && channelFrequency(channel - 1) == channelFrequency(channel))
+      channel--;
+  }
+  return channel;
+}
+
+//******************************************************************************
+//* function: channelFrequency
+//******************************************************************************
+uint16_t channelFrequency( uint8_t channel )
+{
+  return pgm_read_word(tables::frequency + channel);
+}
+
+//******************************************************************************
+//* function: channelBand
+//*         : returns the band plan index of the band a channel belongs to
+//******************************************************************************
+uint8_t channelBand( uint8_t channel )
+{
+  return pgm_read_byte(tables::raw + channel) / BAND_CHANNELS;
+}
+
+//******************************************************************************
+//* function: channelShortName
+//*         : band letter and channel number, e.g. "C1"
+//******************************************************************************
+char *channelShortName( uint8_t channel, char *name )
+{
+  uint8_t raw = pgm_read_byte(tables::raw + channel);
+  name[0] = pgm_read_byte(bandLetters + raw / BAND_CHANNELS);
+  name[1] = (raw % BAND_CHANNELS) + '0' + 1;
+  name[2] = 0;
+  return name;
+}
+
+//******************************************************************************
+//* function: channelLongName
+//*         : band name and channel number, e.g. "Raceband 1"
+//******************************************************************************
+char *channelLongName( uint8_t channel, char *name )
+{
+  uint8_t len;
+  uint8_t raw = pgm_read_byte(tables::raw + channel);
+  strcpy_P(name, bandNames[raw / BAND_CHANNELS]);
+  len = strlen( name );
+  name[len] = (raw % BAND_CHANNELS) + '0' + 1;
+  name[len + 1] = 0;
+  return name;
+}
@@ -0,0 +1,71 @@
+/*******************************************************************************
+  This is the header file for the channel model. All bands are defined once in
+  BAND_PLAN below. The sorted channel order, the reverse index, the frequency
+  table and the band names are generated from it at compile time.
+
+  Channels are numbered in frequency order. That number is what is stored in
+  EEPROM, so bands must only be added after the existing ones.
+
+  The MIT License (MIT)
+
+  Copyright (c) 2017 Kjell Kernen (Dvogonen)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+********************************************************************************/
+#ifndef channels_h
+#define channels_h
+
+#include "Arduino.h"
+
+//******************************************************************************
+//* Band plan
+//* One line per band: letter, long name and the frequencies of its 8 channels.
+//* Custom bands may be appended, up to 8 bands in total. Long names are
+//* padded so that the channel digit lines up on the channel screen.
+
+#define BAND_PLAN(BAND) \
+  BAND('A', "Boscam A",     5865, 5845, 5825, 5805, 5785, 5765, 5745, 5725) \
+  BAND('B', "Boscam B",     5733, 5752, 5771, 5790, 5809, 5828, 5847, 5866) \
+  BAND('E', "Foxtech/DJI ", 5705, 5685, 5665, 5645, 5885, 5905, 5925, 5945) \
+  BAND('F', "FatShark ",    5740, 5760, 5780, 5800, 5820, 5840, 5860, 5880) \
+  BAND('C', "Raceband ",    5658, 5695, 5732, 5769, 5806, 5843, 5880, 5917) \
+  BAND('L', "Lowband  ",    5362, 5399, 5436, 5473, 5510, 5547, 5584, 5621)
+
+#define BAND_ONE(letter, name, ...)     +1
+#define BAND_COUNT                      (0 BAND_PLAN(BAND_ONE))
+#define BAND_CHANNELS                   8
+#define CHANNEL_COUNT                   (BAND_COUNT * BAND_CHANNELS)
+#define BAND_NAME_SIZE                  13    // Longest long name + 1
+#define BAND_ALL                        ((uint8_t)((1 << BAND_COUNT) - 1))
+
+// A frequency this close to the middle of two channels goes to the one with
+// the stronger signal in the spectrum store (in MHz)
+#define CHANNEL_NEAR_MHZ                4
+
+void     channelSetBands( uint8_t bands );
+uint8_t  channelFirst( void );
+uint8_t  channelNext( uint8_t channel );
+uint8_t  channelPrevious( uint8_t channel );
+uint8_t  channelNearest( uint16_t frequency );
+uint16_t channelFrequency( uint8_t channel );
+uint8_t  channelBand( uint8_t channel );
+char    *channelShortName( uint8_t channel, char *name );
+char    *channelLongName( uint8_t channel, char *name );
+
+#endif // channels_h
@@ -40,12 +40,19 @@
 #define OLED_I2C_ADR      0x3C
 
 // SSD1306 and SH1106 OLED displays are supported. Select one.
+// The host simulator selects the SH1106 on the compiler command line.
+#if !defined SSD1306_OLED_DRIVER && !defined SH1106_OLED_DRIVER
 #define SSD1306_OLED_DRIVER 
 //#define SH1106_OLED_DRIVER
+#endif
 
 // This definition is used by the ADAFRUIT library
 #define OLED_128x64_ADAFRUIT_SCREENS
 
+// Print the retune time of the generic and the pin specialized receiver
+// driver on the serial port at startup (115200 baud)
+//#define BENCHMARK_RECEIVER
+
 // User Configuration Options
 #define FLIP_SCREEN_OPTION        0
 #define BATTERY_ALARM_OPTION      1
@@ -86,9 +93,25 @@
 // Number of lines in configuration menu
 #define MAX_OPTION_LINES          7
 
+// RSSI refresh interval of the channel screen (in milli seconds). Only the
+// changed fields are sent to an SH1106, the SSD1306 library always sends
+// the whole frame.
+#ifdef SH1106_OLED_DRIVER
+#define RSSI_REFRESH_MS           50
+#else
+#define RSSI_REFRESH_MS           1000
+#endif
+
 // Delay after key click before screen save (in milli seconds)
 #define SAVE_SCREEN_DELAY_MS      10000
 
+// The screen saver switches the display off. Uncomment to only dim it.
+//#define SAVE_SCREEN_DIM
+
+// Let the processor sleep until the next interrupt when loop() has nothing
+// to do. Timers, the ADC, I2C and the serial port keep running.
+#define IDLE_SLEEP
+
 // Alarm timing constants (in milli seconds)
 #define ALARM_MAX_ON      50
 #define ALARM_MAX_OFF     200
@@ -96,6 +119,7 @@
 #define ALARM_MED_OFF     1000
 #define ALARM_MIN_ON      200
 #define ALARM_MIN_OFF     3000
+#define ALARM_CHECK_MS    250     // Interval between checks while silent
 
 // Digital pin definitions
 #define SPI_CLOCK_PIN     2
@@ -109,28 +133,59 @@
 #define VOLTAGE_METER_PIN A1
 #define RSSI_PIN          A6
 
-// Minimum delay between setting a channel and trusting the RSSI values
+// Analog sampler channels, ADC clock prescaler and filters
+#define ADC_RSSI          0
+#define ADC_VOLTAGE       1
+#define ADC_PRESCALER     ADC_PRESCALER_64    /* 125 kHz ADC clock at 8 MHz */
+#define RSSI_FILTER       ADC_FILTER_TRIMMED
+#define VOLTAGE_FILTER    ADC_FILTER_MEAN
+
+// Maximum delay between setting a channel and trusting the RSSI values
 #define RSSI_STABILITY_DELAY_MS 25
 
-// RSSI threshold for accepting a channel
-#define RSSI_TRESHOLD     250
+// Adaptive settle detection. After a retune the RSSI is trusted as soon as
+// this many consecutive filtered samples agree within the tolerance.
+#define RSSI_SETTLE_COUNT       3
+#define RSSI_SETTLE_TOLERANCE   4
+
+// Print the histogram of settle times on the serial port after each graphic
+// scanner sweep (115200 baud)
+//#define PRINT_SETTLE_TIMES
 
-// Channels in use 
-#define CHANNEL_MIN       (options[L_BAND_OPTION] ? 0 : 8)
-#define CHANNEL_MAX       47
+// The RSSI levels for accepting a channel are learned, see noisefloor.h
 
 //* Frequency resolutions
 #define SCANNING_STEP     (options[L_BAND_OPTION] ? 6 : 3)
 
+// Distance between the fine tuning probes and the peak estimate. Kept even so
+// that the probes stay on the odd frequencies the RTC6715 can generate.
+#define FINE_TUNE_SPAN    ((SCANNING_STEP + 1) & ~1)
+#define FINE_TUNE_PROBES  4
+
 // Max and Min frequencies
 #define FREQUENCY_MIN     (options[L_BAND_OPTION] ? 5345 : 5645)
 #define FREQUENCY_MAX     5945
 
-//EEPROM addresses
+//EEPROM addresses of the layout before the settings store, see settings.h.
+//Only read to migrate the settings of older firmware.
 #define EEPROM_CHANNEL    0
 #define EEPROM_OPTIONS    1
 #define EEPROM_CHECK      (EEPROM_OPTIONS + MAX_OPTIONS)
 
+// Scan engine modes
+#define SCAN_IDLE             0
+#define SCAN_GRAPHIC          1
+#define SCAN_AUTO             2
+#define SCAN_FINE             3
+#define SCAN_WATERFALL        4
+
+// The auto scanner jumps straight to peaks found by a graphic sweep that is
+// at most this old (in milli seconds)
+#define SPECTRUM_MAX_AGE_MS   30000
+
+// Number of coarse steps before the auto scanner gives up
+#define AUTO_SCAN_MAX_STEPS   60
+
 // click types
 #define NO_CLICK              0
 #define SINGLE_CLICK          1
@@ -141,6 +196,11 @@
 // Button pins go low or high on button clicks
 #define BUTTON_PRESSED    LOW
 
+// Where a double click has no meaning, like when the screen saver is on,
+// a single click is acted upon at the release instead of after the double
+// click window. Set to false to always wait for a second click.
+#define INSTANT_CLICKS    true
+
 // LED state defines
 #define LED_OFF           LOW
 #define LED_ON            HIGH
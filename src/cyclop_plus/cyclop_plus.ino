@@ -35,6 +35,19 @@
 // Application includes
 #include "cyclop_plus.h"
 #include "rtc6715.h"
+#include "adcsampler.h"
+#include "spectrum.h"
+#include "waterfall.h"
+#include "noisefloor.h"
+#include "battery.h"
+#include "button.h"
+#include "channels.h"
+#include "profiler.h"
+#include "stream.h"
+#include "settings.h"
+#include "eepromqueue.h"
+#include "scheduler.h"
+#include "widgets.h"
 
 // Library includes
 #include <avr/pgmspace.h>
@@ -44,96 +57,74 @@
 #include <Adafruit_SSD1306.h>
 #endif
 #ifdef SH1106_OLED_DRIVER
-#include "libraries/adafruit_sh1106/Adafruit_SH1106.h"
+#include "libraries/Adafruit_SH1106/Adafruit_SH1106.h"
 #endif
 #include <Adafruit_GFX.h>
-#include <EnableInterrupt.h>
+#ifdef __AVR__
+#include <avr/sleep.h>
+#endif
 
 //******************************************************************************
 //* File scope function declarations
 
 void     activateScreenSaver( void );
-uint16_t autoScan( uint16_t frequency );
-uint16_t averageAnalogRead( uint8_t pin );
+void     deactivateScreenSaver( void );
+void     autoScan( uint16_t frequency );
 void     batteryMeter(void);
-void     buttonPressInterrupt();
-uint8_t  bestChannelMatch( uint16_t frequency );
+void     benchmarkReceiver( void );
 void     dissolveDisplay(void);
 void     drawAutoScanScreen(void);
 void     drawBattery(uint8_t xPos, uint8_t yPos, uint8_t value );
 void     drawChannelScreen( uint8_t channel, uint16_t rssi);
+void     drawFunctionScreen( uint8_t function );
+void     drawOption( uint8_t option );
 void     drawOptionsScreen(uint8_t option, uint8_t in_edit_state);
+void     drawScannerColumn( uint8_t column );
 void     drawScannerScreen( void );
 void     drawStartScreen(void);
-uint8_t  getClickType(uint8_t buttonPin);
-uint16_t getVoltage( void );
-uint16_t graphicScanner( uint16_t frequency );
-char    *longNameOfChannel(uint8_t channel, char *name);
-uint8_t  nextChannel( uint8_t channel);
-uint8_t  previousChannel( uint8_t channel);
+void     drawWaterfallScreen( void );
+void     drawDiagnosticsScreen( uint8_t page );
+void     flushDisplay( void );
+void     graphicScanner( uint16_t frequency );
+void     hopChannel( uint8_t channel );
+void     idleSleep( void );
 bool     readEeprom(void);
 void     resetOptions(void);
-char    *shortNameOfChannel(uint8_t channel, char *name);
+int16_t  parabolaOffset( int16_t left, int16_t center, int16_t right, int16_t spacing );
+void     scanCancel( void );
+uint8_t  scannerLayer( uint8_t x, uint8_t page );
+void     scrollDisplay( uint8_t line );
+uint8_t  selectFunction( void );
+void     scanFinish( uint16_t frequency );
+bool     scanSettled( void );
+void     printSettleTimes( void );
+void     pulseLed( void );
+void     refreshChannelScreen( void );
+void     sampleBattery( void );
+void     saveSettings( void );
+void     screenSaverTimeout( void );
+void     scanStart( uint8_t mode, uint16_t frequency );
+void     scanStartFine( uint16_t frequency );
+void     scanTick( void );
+void     scanTune( uint16_t frequency );
+void     sweepStart( uint8_t mode, uint16_t frequency );
 void     setOptions( void );
+void     showDiagnostics( void );
 void     spi_0(void);
 void     spi_1(void);
 void     spiEnableHigh( void );
 void     spiEnableLow( void );
 int16_t  spiRead( void );
 void     testAlarm( void );
-void     updateScannerScreen(uint8_t position, uint8_t value );
+void     toggleAlarm( void );
+uint8_t  rssiToBarHeight( uint16_t rssi );
+void     updateBands( void );
+void     updateScannerScreen( uint8_t column );
+void     updateWaterfallScreen( void );
+void     waterfallScanner( uint16_t frequency );
+uint8_t  waterfallLayer( uint8_t x, uint8_t page );
 void     writeEeprom(void);
 
-//******************************************************************************
-//* Positions in the frequency table for the 48 channels
-//* Direct access via array operations does not work since data is stored in
-//* flash, not in RAM. Use getPosition to retrieve data
-
-const uint8_t positions[] PROGMEM = {
-  40, 41, 42, 43, 44, 45, 46, 47, 19, 32, 18, 17, 33, 16,  7, 34,
-  8, 24,  6,  9, 25,  5, 35, 10, 26,  4, 11, 27,  3, 36, 12, 28,
-  2, 13, 29, 37,  1, 14, 30,  0, 15, 31, 38, 20, 21, 39, 22, 23
-};
-
-uint16_t getPosition( uint8_t channel ) {
-  return pgm_read_byte_near(positions + channel);
-}
-
-//******************************************************************************
-//* Frequencies for the 48 channels
-//* Direct access via array operations does not work since data is stored in
-//* flash, not in RAM. Use getFrequency to retrieve data
-
-const uint16_t channelFrequencies[] PROGMEM = {
-  5865, 5845, 5825, 5805, 5785, 5765, 5745, 5725, // Band A - Boscam A
-  5733, 5752, 5771, 5790, 5809, 5828, 5847, 5866, // Band B - Boscam B
-  5705, 5685, 5665, 5645, 5885, 5905, 5925, 5945, // Band E - DJI
-  5740, 5760, 5780, 5800, 5820, 5840, 5860, 5880, // Band F - FatShark \ Immersion
-  5658, 5695, 5732, 5769, 5806, 5843, 5880, 5917, // Band R - Raceband
-  5362, 5399, 5436, 5473, 5510, 5547, 5584, 5621  // Band L - Lowband
-};
-
-uint16_t getFrequency( uint8_t channel ) {
-  return pgm_read_word_near(channelFrequencies + getPosition(channel));
-}
-//******************************************************************************
-//* Reverse lookup for frequencies in position table
-//* Direct access via array operations does not work since data is stored in
-//* flash, not in RAM. Use getRevesePositions to retrieve data
-
-const uint16_t reversePositions[] PROGMEM = {
-  39, 36, 32, 28, 25, 21, 18, 14, // Band A - Boscam A
-  16, 19, 23, 26, 30, 33, 37, 40, // Band B - Boscam B
-  13, 11, 10,  8, 43, 44, 46, 47, // Band E - DJI
-  17, 20, 24, 27, 31, 34, 38, 41, // Band F - FatShark \ Immersion
-  9,  12, 15, 22, 29, 35, 42, 45, // Band R - Raceband
-  0,   1,  2,  3,  4,  5,  6,  7  // Band L - Lowband
-};
-
-uint16_t getReversePosition( uint8_t position ) {
-  return pgm_read_word_near(reversePositions + position);
-}
-
 //******************************************************************************
 //* Other file scope variables
 #ifdef SSD1306_OLED_DRIVER
@@ -146,25 +137,68 @@ Adafruit_SH1106 display(4);
 uint8_t  lastClick = NO_CLICK;
 uint8_t  currentChannel = 0;
 uint8_t  lastChannel = 0;
-uint8_t  clickType = NO_CLICK;
 uint8_t  ledState = LED_ON;
 uint8_t  alarmSoundOn = 0;
+uint8_t  alarmTest = 0;
 uint8_t  options[MAX_OPTIONS];
 uint8_t  saveScreenActive = 0;
-uint8_t  softPositions[48];
+uint8_t  menuActive = 0;
+uint8_t  scannerCursor = 0;
+uint8_t  channelScreenShown = 0;
+uint8_t  hopPending = 0;
 
 uint16_t currentRssi = 0;
 uint16_t alarmOnPeriod = 0;
 uint16_t alarmOffPeriod = 0;
-uint32_t pauseStart = 0;
-uint32_t saveScreenTimer;
 
-uint32_t displayUpdateTimer = 0;
-uint32_t eepromSaveTimer = 0;
-uint32_t pulseTimer = 0;
-uint32_t alarmTimer = 0;
+uint8_t  swallowClick = 0;
+
+uint8_t  scanMode = SCAN_IDLE;
+uint8_t  scanStep = 0;
+uint8_t  scanButtonDown = 0;
+uint8_t  scanArmed = 0;
+uint16_t scanFrequency = 0;
+uint16_t scanShownFrequency = 0;
+uint16_t scanBestFrequency = 0;
+uint16_t scanBestRssi = 0;
+uint16_t scanSweepTime = 0;
+uint32_t scanTuneTime = 0;
+uint32_t scanSweepStart = 0;
+uint16_t fineFrequency[FINE_TUNE_PROBES];
+uint16_t fineRssi[FINE_TUNE_PROBES];
+
+uint8_t  settleTuneCount = 0;
+uint8_t  settleSampleCount = 0;
+uint8_t  settleStableCount = 0;
+uint8_t  settleFull = 0;
+uint16_t settleLastRssi = 0;
+uint16_t settleHistogram[RSSI_STABILITY_DELAY_MS + 1];
+
+uint8_t  ledTask;
+uint8_t  batteryTask;
+uint8_t  alarmTask;
+uint8_t  saveTask;
+uint8_t  refreshTask;
+uint8_t  screenSaverTask;
+
+// Fields of the channel screen that change. The name and RSSI row starts
+// on a page boundary, so an RSSI update touches two pages instead of three.
+widget   frequencyWidget = { 10,  0,  72, 21, 3, 0, false };
+widget   nameWidget      = { 24, 40,  24, 14, 2, 0, false };
+widget   rssiWidget      = { 72, 40,  48, 14, 2, 0, false };
+widget   batteryWidget   = { 58, 32,  10, 22, 1, 0, false };
+widget   bandWidget      = {  0, 57, 128,  7, 1, 0, false };
+widget   averageWidget   = { 72, 55,  48,  2, 1, 0, false };
+
+#ifdef SH1106_PAGE_BUFFER
+// A new row is rendered with the rows that share its page
+uint8_t  waterfallHistory[WATERFALL_PAGE_ROWS * WATERFALL_ROW_BYTES];
+#else
+// The older rows are kept as pixels in the framebuffer
+uint8_t  waterfallHistory[WATERFALL_ROW_BYTES];
+#endif
 
-rtc6715  receiver( SPI_CLOCK_PIN, SLAVE_SELECT_PIN, SPI_DATA_PIN );
+rtc6715_fast<SPI_CLOCK_PIN, SLAVE_SELECT_PIN, SPI_DATA_PIN> receiver;
 
 //******************************************************************************
 //* function: setup
@@ -177,19 +211,34 @@ void setup()
 
   // initialize button pin
   pinMode(BUTTON_PIN, INPUT_PULLUP);
-  enableInterrupt(BUTTON_PIN, buttonPressInterrupt, CHANGE);
+  buttonBegin(BUTTON_PIN, BUTTON_PRESSED);
 
   // initialize alarm
   pinMode(ALARM_PIN, OUTPUT );
 
   // Read current channel and options data from EEPROM
   if (!readEeprom()) {
-    currentChannel = CHANNEL_MIN;
     resetOptions();
+    currentChannel = channelFirst();
   }
+  updateBands();
+  if (currentChannel >= CHANNEL_COUNT)
+    currentChannel = channelFirst();
+  lastChannel = currentChannel;
+
+  // Start sampling RSSI and battery voltage in the background
+  adcSetChannel(ADC_RSSI, RSSI_PIN, RSSI_FILTER);
+  adcSetChannel(ADC_VOLTAGE, VOLTAGE_METER_PIN, VOLTAGE_FILTER);
+  adcBegin(ADC_PRESCALER);
+#ifdef STREAM_SPECTRUM
+  streamBegin();
+#endif
 
   // Start receiver
-  receiver.setFrequency(getFrequency(currentChannel));
+  receiver.setFrequency(channelFrequency(currentChannel));
+#ifdef BENCHMARK_RECEIVER
+  benchmarkReceiver();
+#endif
 
   // Initialize the display
 #ifdef SSD1306_OLED_DRIVER
@@ -201,21 +250,32 @@ void setup()
   display.clearDisplay();
   if (options[FLIP_SCREEN_OPTION])
     display.setRotation(2);
-  display.display();
+  flushDisplay();
+
+  // Background tasks, they also run while menus are shown. Added once the
+  // display is up, so they do not start out late.
+  ledTask = schedulerAdd(pulseLed, 500, 500);
+  batteryTask = schedulerAdd(sampleBattery, 0, BATTERY_SAMPLE_MS);
+  alarmTask = schedulerAdd(toggleAlarm, 0, 0);
+  saveTask = schedulerAdd(saveSettings, 10000, 10000);
 
   // Set Options
-  if (digitalRead(BUTTON_PIN) == BUTTON_PRESSED ) {
+  if (buttonDown()) {
+    menuActive = 1;
     setOptions();
     writeEeprom();
     if (options[FLIP_SCREEN_OPTION])
       display.setRotation(2);
+    menuActive = 0;
   }
   // Show start screen
   if (options[SHOW_STARTSCREEN_OPTION])
     drawStartScreen();
 
-  // Wait at least the delay time before entering screen save mode
-  saveScreenTimer = millis() + SAVE_SCREEN_DELAY_MS;
+  // Show the channel screen at once, and wait at least the delay time before
+  // entering screen save mode
+  refreshTask = schedulerAdd(refreshChannelScreen, 0, RSSI_REFRESH_MS);
+  screenSaverTask = schedulerAdd(screenSaverTimeout, SAVE_SCREEN_DELAY_MS, 0);
 }
 
 //******************************************************************************
@@ -223,498 +283,675 @@ void setup()
 //******************************************************************************
 void loop()
 {
-  switch (lastClick = getClickType( BUTTON_PIN ))
+  PROFILE_BEGIN(PROFILE_LOOP);
+
+  // While a scan is running the scan engine owns the button and the screen
+  if (scanMode != SCAN_IDLE) {
+    scanTick();
+    lastClick = NO_CLICK;
+  }
+  else
+  {
+    lastClick = buttonClick();
+
+    // The click that stopped a scan has already been acted upon
+    if (swallowClick && lastClick != NO_CLICK) {
+      swallowClick = 0;
+      lastClick = NO_CLICK;
+    }
+    // Any click only wakes the display
+    else if (saveScreenActive && lastClick != NO_CLICK)
+      lastClick = WAKEUP_CLICK;
+  }
+
+  switch (lastClick)
   {
     case NO_CLICK: // do nothing
       break;
 
-    case WAKEUP_CLICK:  // do nothing
+    case WAKEUP_CLICK:
+      deactivateScreenSaver();
       break;
 
     case LONG_CLICK:
+        menuActive = 1;
         switch (selectFunction())
         {
           case 1:
-            currentChannel = bestChannelMatch(graphicScanner(getFrequency(currentChannel)));
-            drawChannelScreen(currentChannel, 0);
-            displayUpdateTimer = millis() +  RSSI_STABILITY_DELAY_MS ;
+            graphicScanner(channelFrequency(currentChannel));
             break;
           case 2:
-            drawAutoScanScreen();
-            currentChannel = bestChannelMatch(autoScan(getFrequency(currentChannel)));
-            drawChannelScreen(currentChannel, 0);
-            displayUpdateTimer = millis() +  RSSI_STABILITY_DELAY_MS ;
+            autoScan(channelFrequency(currentChannel));
             break;
           case 3:
+            waterfallScanner(channelFrequency(currentChannel));
+            break;
+          case 4:
             setOptions();
             writeEeprom();
             if (options[FLIP_SCREEN_OPTION])
               display.setRotation(2);
             break;
+#ifdef PROFILE_PHASES
+          case 5:
+            showDiagnostics();
+            break;
+#endif
         }
+        menuActive = 0;
       break;
 
     case SINGLE_CLICK: // up the frequency
-      currentChannel = nextChannel( currentChannel );
-      receiver.setFrequency(getFrequency(currentChannel));
-      drawChannelScreen(currentChannel, 0);
+      hopChannel( channelNext( currentChannel ) );
       break;
 
     case DOUBLE_CLICK:  // down the frequency
-      currentChannel = previousChannel( currentChannel );
-      receiver.setFrequency(getFrequency(currentChannel));
-      drawChannelScreen(currentChannel, 0);
+      hopChannel( channelPrevious( currentChannel ) );
       break;
   }
-  // Reset screensaver timer after each key click
+  // Restart the screensaver delay after each key click
   if  (lastClick != NO_CLICK )
-    saveScreenTimer = millis() + SAVE_SCREEN_DELAY_MS;
+    schedulerStart(screenSaverTask, SAVE_SCREEN_DELAY_MS);
 
-  // Check if the display needs updating
-  if ( millis() > displayUpdateTimer ) {
-    if ( options[SAVE_SCREEN_OPTION] && (saveScreenTimer < millis()))
-      activateScreenSaver();
-    else
-    {
-      currentRssi = averageAnalogRead(RSSI_PIN);
-      drawChannelScreen(currentChannel, currentRssi);
-      displayUpdateTimer = millis() + 1000;
-    }
-  }
-  // Check if EEPROM needs a save. Reduce EEPROM writes by not saving to often
-  if ((currentChannel != lastChannel) && (millis() > eepromSaveTimer))
-  {
-    writeEeprom();
-    lastChannel = currentChannel;
-    eepromSaveTimer = millis() + 10000;
-  }
-  // Check if it is time to switch LED state for the pulse led
-  if ( millis() > pulseTimer ) {
-    ledState = !ledState;
-    pulseTimer = millis() + 500;
-  }
-  digitalWrite(LED_PIN, ledState);
+  schedulerRun();
 
-  // Toggle alarm on or off
-  if (options[BATTERY_ALARM_OPTION] && alarmOnPeriod) {
-    if (millis() > alarmTimer) {
-      alarmSoundOn = !alarmSoundOn;
-      if (alarmSoundOn) {
-        analogWrite( ALARM_PIN, 1 << options[ALARM_LEVEL_OPTION] -1 );
-        alarmTimer = millis() + alarmOnPeriod;
-      }
-      else {
-        analogWrite( ALARM_PIN, 0 );
-        alarmTimer = millis() + alarmOffPeriod;
-      }
-    }
+  PROFILE_END(PROFILE_LOOP);
+  idleSleep();
+}
+
+//******************************************************************************
+//* function: hopChannel
+//*         : retunes to a channel at once and leaves the channel screen to
+//*         : the refresh task, which draws it when the RSSI has settled.
+//*         : Each hop moves the refresh on, so a run of quick clicks is
+//*         : drawn once, after the last of them.
+//******************************************************************************
+void hopChannel( uint8_t channel )
+{
+  if (!hopPending) {
+    PROFILE_BEGIN(PROFILE_HOP);
   }
-  else
-    analogWrite( ALARM_PIN, 0 );
+  currentChannel = channel;
+  receiver.setFrequency(channelFrequency(channel));
+  hopPending = 1;
+  schedulerStart(refreshTask, RSSI_STABILITY_DELAY_MS);
 }
 
 //******************************************************************************
-//* function: writeEeprom
-//*         : Writes all configuration settings to nonvolatile memory
+//* function: idleSleep
+//*         : stops the processor until the next interrupt. The millis() timer,
+//*         : the button timer and the ADC sampler wake it up every millisecond.
 //******************************************************************************
-void writeEeprom(void) {
-  uint8_t i;
-  EEPROM.write(EEPROM_CHANNEL, currentChannel);
-  for (i = 0; i < MAX_OPTIONS; i++)
-    EEPROM.write(EEPROM_OPTIONS + i, options[i]);
-  EEPROM.write(EEPROM_CHECK, VER_EEPROM);
+void idleSleep( void )
+{
+#if defined IDLE_SLEEP && defined __AVR__
+  set_sleep_mode(SLEEP_MODE_IDLE);
+  sleep_mode();
+#endif
 }
 
 //******************************************************************************
-//* function: readEeprom
-//*         : Reads all configuration settings from nonvolatile memory
+//* Background tasks, run by the scheduler
 //******************************************************************************
-bool readEeprom(void) {
-  uint8_t i;
-  if (EEPROM.read(EEPROM_CHECK) != VER_EEPROM)
-    return false;
-  currentChannel =   EEPROM.read(EEPROM_CHANNEL);
-  for (i = 0; i < MAX_OPTIONS; i++)
-    options[i] = EEPROM.read(EEPROM_OPTIONS + i);
-  return true;
+//******************************************************************************
+//* function: pulseLed
+//*         : task, toggles the pulse LED
+//******************************************************************************
+void pulseLed( void )
+{
+  ledState = !ledState;
+  digitalWrite(LED_PIN, ledState);
 }
 
 //******************************************************************************
-//* function: buttonPressInterrupt
-//*         : This function is called when the button interrupt fires.
-//*         : This happens both on button down and button up
+//* function: refreshChannelScreen
+//*         : task, redraws the channel screen with a new RSSI value, the
+//*         : first draw after a channel hop shows the new channel
 //******************************************************************************
-void buttonPressInterrupt() {
-  static long clickStart = 0;
+void refreshChannelScreen( void )
+{
+  if (scanMode != SCAN_IDLE || menuActive || saveScreenActive)
+    return;
+  currentRssi = adcRead(ADC_RSSI);
+  drawChannelScreen(currentChannel, currentRssi);
+  if (hopPending) {
+    hopPending = 0;
+    PROFILE_END(PROFILE_HOP);
+  }
+}
 
-  if ( digitalRead(BUTTON_PIN) == BUTTON_PRESSED ) {// Button was pressed
-    clickStart = millis();
+//******************************************************************************
+//* function: saveSettings
+//*         : task, saves the channel if it has changed, or the noise levels if
+//*         : they have moved. Reduces EEPROM writes by not saving too often.
+//******************************************************************************
+void saveSettings( void )
+{
+  if (currentChannel != lastChannel || noiseUnsaved()) {
+    writeEeprom();
+    lastChannel = currentChannel;
   }
-  else {                                            // Button was released
-    if ( pauseStart) {
-      clickType = DOUBLE_CLICK;
-      clickStart = 0;
-      pauseStart = 0;
+}
+
+//******************************************************************************
+//* function: screenSaverTimeout
+//*         : one-shot task, started again by each key click
+//******************************************************************************
+void screenSaverTimeout( void )
+{
+  if (options[SAVE_SCREEN_OPTION] && scanMode == SCAN_IDLE && !menuActive)
+    activateScreenSaver();
+}
+
+//******************************************************************************
+//* function: toggleAlarm
+//*         : one-shot task that starts itself again, switches the alarm on
+//*         : and off while the battery is low, or at the fastest rate while
+//*         : the alarm is tested
+//******************************************************************************
+void toggleAlarm( void )
+{
+  if (alarmTest || (options[BATTERY_ALARM_OPTION] && alarmOnPeriod)) {
+    alarmSoundOn = !alarmSoundOn;
+    if (alarmSoundOn) {
+      analogWrite( ALARM_PIN, 1 << options[ALARM_LEVEL_OPTION] -1 );
+      schedulerStart(alarmTask, alarmTest ? ALARM_MAX_ON : alarmOnPeriod);
     }
-    else
-    {
-      if ( saveScreenActive ) {
-        clickType = WAKEUP_CLICK;
-        clickStart = 0;
-        saveScreenActive = 0;
-      }
-      else if (( millis() - clickStart) > 350 )
-        clickType = LONG_CLICK;
-      else
-        clickType = SINGLE_CLICK;
-      clickStart = 0;
-      pauseStart = millis();
+    else {
+      analogWrite( ALARM_PIN, 0 );
+      schedulerStart(alarmTask, alarmTest ? ALARM_MAX_OFF : alarmOffPeriod);
     }
   }
+  else {
+    alarmSoundOn = 0;
+    analogWrite( ALARM_PIN, 0 );
+    schedulerStart(alarmTask, ALARM_CHECK_MS);
+  }
 }
 
 //******************************************************************************
-//* function: getClickType
+//* function: writeEeprom
+//*         : Saves the configuration settings to nonvolatile memory, if they
+//*         : have changed since the last save. Returns before the bytes are
+//*         : programmed.
 //******************************************************************************
-uint8_t getClickType(uint8_t buttonPin) {
-  uint8_t tempClickType = NO_CLICK;
+void writeEeprom(void) {
+  uint8_t levels[NOISE_LEVELS];
 
-  if (pauseStart && (millis() - pauseStart) < 350)
-    return NO_CLICK;
+  PROFILE_BEGIN(PROFILE_EEPROM);
+  noiseSave(levels);
+  settingsSave(currentChannel, options, levels);
+  PROFILE_END(PROFILE_EEPROM);
+}
 
-  pauseStart = 0;
+//******************************************************************************
+//* function: readEeprom
+//*         : Reads all configuration settings and the learned noise levels
+//*         : from nonvolatile memory
+//******************************************************************************
+bool readEeprom(void) {
+  uint8_t levels[NOISE_LEVELS];
+  bool    found;
 
-  if ( clickType ) {
-    tempClickType = clickType;
-    clickType = NO_CLICK;
-  }
-  return tempClickType;
+  found = settingsLoad(&currentChannel, options, levels);
+  noiseBegin(levels);
+  return found;
 }
 
+#ifdef BENCHMARK_RECEIVER
 //******************************************************************************
-//* function: nextChannel
+//* function: benchmarkReceiver
+//*         : times 100 retunes with the generic and the pin specialized
+//*         : receiver driver and prints the average on the serial port
 //******************************************************************************
-uint8_t incrementChannel(uint8_t channel)
+void benchmarkReceiver( void )
 {
-  if (channel > (CHANNEL_MAX - 1))
-    return CHANNEL_MIN;
-  else
-    return channel + 1;
-}
+  rtc6715  genericReceiver( SPI_CLOCK_PIN, SLAVE_SELECT_PIN, SPI_DATA_PIN );
+  uint32_t start;
+  uint32_t genericTime;
+  uint32_t fastTime;
+  uint8_t  i;
 
-uint8_t nextChannel(uint8_t channel)
-{
-  do {
-    channel = incrementChannel( channel);
-  } while (softPositions[channel] == 255);
-  return channel;
+  start = micros();
+  for (i = 0; i < 100; i++)
+    genericReceiver.setFrequency(FREQUENCY_MAX - i * 2);
+  genericTime = micros() - start;
+
+  start = micros();
+  for (i = 0; i < 100; i++)
+    receiver.setFrequency(FREQUENCY_MAX - i * 2);
+  fastTime = micros() - start;
+
+  Serial.begin(115200);
+  Serial.print(F("rtc6715 retune us: "));
+  Serial.println(genericTime / 100);
+  Serial.print(F("rtc6715_fast retune us: "));
+  Serial.println(fastTime / 100);
+  Serial.flush();
+
+  receiver.setFrequency(channelFrequency(currentChannel));
 }
+#endif
 
 //******************************************************************************
-//* function: previousChannel
+//* Scan engine
+//*         : The graphic scanner, the auto scanner and the fine tuning that
+//*         : follows both run as one state machine that loop() ticks. When
+//*         : the RSSI of the current step has settled it is read, the
+//*         : receiver is retuned to the next step at once, and only then is
+//*         : the sample rendered. The screen update of one step thereby
+//*         : overlaps the settle time of the next, and loop() keeps serving
+//*         : the LED, the alarm and the button while a scan runs.
 //******************************************************************************
-uint8_t decrementChannel(uint8_t channel)
-{
-  if (channel > CHANNEL_MAX)
-    return CHANNEL_MAX;
 
-  if ( channel == CHANNEL_MIN )
-    return CHANNEL_MAX;
+//******************************************************************************
+//* function: graphicScanner
+//*         : starts a scan of the 5.8 GHz band with a graphical representation
+//*         : a button press stops the sweep and fine tunes the last frequency
+//******************************************************************************
+void graphicScanner( uint16_t frequency ) {
+  // Keep the stored spectrum unless the scanned range has changed
+  if (!spectrumMatches(FREQUENCY_MIN, FREQUENCY_MAX))
+    spectrumReset(FREQUENCY_MIN, FREQUENCY_MAX);
 
-  return channel - 1;
+  // Draw screen frame and the stored spectrum
+  drawScannerScreen();
+  sweepStart(SCAN_GRAPHIC, frequency);
 }
 
-uint8_t previousChannel(uint8_t channel)
-{
-  do {
-    channel = decrementChannel( channel );
-  } while (softPositions[channel] == 255);
-  return channel;
+//******************************************************************************
+//* function: waterfallScanner
+//*         : sweeps the band like the graphic scanner and shows each sweep
+//*         : as a row of a waterfall, a button press ends it
+//******************************************************************************
+void waterfallScanner( uint16_t frequency ) {
+  if (!spectrumMatches(FREQUENCY_MIN, FREQUENCY_MAX))
+    spectrumReset(FREQUENCY_MIN, FREQUENCY_MAX);
+
+  drawWaterfallScreen();
+  sweepStart(SCAN_WATERFALL, frequency);
 }
 
 //******************************************************************************
-//* function: bestChannelMatch
-//*         : finds the best matching standard channel for a given frequency
+//* function: sweepStart
+//*         : starts sweeping the band at the step after frequency
 //******************************************************************************
-uint8_t bestChannelMatch( uint16_t frequency )
-{
-  int16_t comp;
-  int16_t bestComp = 300;
-  uint8_t bestChannel = CHANNEL_MIN;
-  uint8_t i;
+void sweepStart( uint8_t mode, uint16_t frequency ) {
+  frequency += SCANNING_STEP;
+  if (frequency > FREQUENCY_MAX)
+    frequency = FREQUENCY_MIN;
+  scanSweepStart = millis();
+#ifdef STREAM_SPECTRUM
+  streamSweep(FREQUENCY_MIN, FREQUENCY_MAX, SCANNING_STEP);
+#endif
+  scanStart(mode, frequency);
+}
 
-  for (i = CHANNEL_MIN; i <= CHANNEL_MAX; i++) {
-    comp = abs( (int16_t)getFrequency(i) - (int16_t)frequency );
-    if (comp < bestComp)
-    {
-      bestComp = comp;
-      bestChannel = i;
+//******************************************************************************
+//* function: autoScan
+//*         : starts a search for the next frequency with an RSSI above the
+//*         : learned enter level, a button press cancels the search
+//******************************************************************************
+void autoScan( uint16_t frequency ) {
+  uint8_t column;
+
+  drawAutoScanScreen();
+
+  // Jump straight to the next known peak if the band was swept recently
+  if (spectrumMatches(FREQUENCY_MIN, FREQUENCY_MAX) && spectrumSweeps() && (spectrumAge() < SPECTRUM_MAX_AGE_MS)) {
+    column = spectrumNextPeak(spectrumColumn(frequency), noiseEnter() >> 2, noiseLeave() >> 2);
+    if (column != 255) {
+      scanStartFine(spectrumFrequency(column));
+      return;
     }
   }
-  return bestChannel;
+  if (!spectrumMatches(FREQUENCY_MIN, FREQUENCY_MAX))
+    spectrumReset(FREQUENCY_MIN, FREQUENCY_MAX);
+
+  // Skip forward to avoid detecting the current channel
+  frequency += SCANNING_STEP;
+  if (!(frequency % 2))
+    frequency++;        // RTC6715 can only generate odd frequencies
+  if (frequency > FREQUENCY_MAX)
+    frequency = FREQUENCY_MIN;
+  scanStart(SCAN_AUTO, frequency);
 }
 
 //******************************************************************************
-//* function: graphicScanner
-//*         : scans the 5.8 GHz band and draws a graphical representation.
-//*         : when the button is pressed the current frequency is returned.
+//* function: scanStart
+//******************************************************************************
+void scanStart( uint8_t mode, uint16_t frequency ) {
+  scanMode = mode;
+  scanStep = 0;
+  scanBestRssi = 0;
+  scanBestFrequency = frequency;
+  scanShownFrequency = frequency;
+  scanArmed = 0;
+  scanButtonDown = buttonDown();
+  scanTune(frequency);
+  // The receiver may come from a strong channel, the RSSI then falls slowly
+  // enough to pass the adaptive check long before it has settled
+  settleFull = 1;
+}
+
 //******************************************************************************
-uint16_t graphicScanner( uint16_t frequency ) {
-  uint8_t  i;
-  uint8_t  clickType;
-  uint8_t  rssiDisplayValue;
-  uint16_t scanRssi;
-  uint16_t bestRssi = 0;
-  uint16_t scanFrequency = frequency;
-  uint16_t bestFrequency = frequency;
-
-  // Draw screen frame etc
-  drawScannerScreen();
+//* function: parabolaOffset
+//*         : fits a parabola through three samples taken spacing MHz apart
+//*         : and returns the offset of its top from the center sample.
+//*         : Returns 0 if the samples do not describe a peak.
+//******************************************************************************
+int16_t parabolaOffset( int16_t left, int16_t center, int16_t right, int16_t spacing ) {
+  int32_t curve = (int32_t)left - 2 * center + right;
+  int32_t offset;
+
+  if (curve >= 0)
+    return 0;
+  // Calculated in half MHz and rounded to the nearest MHz
+  offset = (int32_t)spacing * (left - right) / curve;
+  offset = (offset + (offset > 0) - (offset < 0)) / 2;
+  if (offset > spacing)
+    return spacing;
+  if (offset < -spacing)
+    return -spacing;
+  return offset;
+}
 
-  while (digitalRead(BUTTON_PIN) != BUTTON_PRESSED) {
-    scanFrequency += SCANNING_STEP;
-    if (scanFrequency > FREQUENCY_MAX)
-      scanFrequency = FREQUENCY_MIN;
-    receiver.setFrequency(scanFrequency);
-    delay( RSSI_STABILITY_DELAY_MS );
-    scanRssi = averageAnalogRead(RSSI_PIN);
-    rssiDisplayValue = (scanRssi - 140) / 10;    // Roughly 2 - 46
-    updateScannerScreen(100 - ((FREQUENCY_MAX - scanFrequency) / SCANNING_STEP), rssiDisplayValue );
-  }
-  // Fine tuning
-  scanFrequency = scanFrequency - SCANNING_STEP * 4;
-  for (i = 0; i < SCANNING_STEP * 4; i++, scanFrequency += 2) {
-    receiver.setFrequency(scanFrequency);
-    delay( RSSI_STABILITY_DELAY_MS );
-    scanRssi = averageAnalogRead(RSSI_PIN);
-    if (bestRssi < scanRssi) {
-      bestRssi = scanRssi;
-      bestFrequency = scanFrequency;
-    }
+//******************************************************************************
+//* function: scanStartFine
+//*         : refines a coarse peak with a few targeted probes. The peak is
+//*         : first estimated from the stored coarse samples around it. The
+//*         : receiver then probes the estimate and FINE_TUNE_SPAN MHz to each
+//*         : side, and a parabola through those three samples gives the
+//*         : final probe. The strongest probe wins.
+//******************************************************************************
+void scanStartFine( uint16_t frequency ) {
+  uint8_t column = spectrumColumn(frequency);
+  uint8_t left, center, right;
+
+  // Interpolate between the coarse samples if both neighbours are known
+  if (column != 255 && column > 0 && column < SPECTRUM_COLUMNS - 1) {
+    left = spectrumCurrent(column - 1);
+    center = spectrumCurrent(column);
+    right = spectrumCurrent(column + 1);
+    if (left && center && right)
+      frequency = spectrumFrequency(column) +
+                  parabolaOffset(left, center, right, spectrumFrequency(column + 1) - spectrumFrequency(column));
   }
-  // Return the best frequency
-  receiver.setFrequency(bestFrequency);
-  return (bestFrequency);
+  frequency |= 1;       // RTC6715 can only generate odd frequencies
+
+  fineFrequency[0] = frequency;
+  fineFrequency[1] = frequency - FINE_TUNE_SPAN;
+  fineFrequency[2] = frequency + FINE_TUNE_SPAN;
+
+  scanMode = SCAN_FINE;
+  scanStep = 0;
+  scanBestRssi = 0;
+  scanBestFrequency = frequency;
+  scanTune(frequency);
 }
 
 //******************************************************************************
-//* function: autoScan
+//* function: scanTune
 //******************************************************************************
-uint16_t autoScan( uint16_t frequency ) {
-  uint8_t  i;
-  uint16_t scanRssi = 0;
-  uint16_t bestRssi = 0;
-  uint16_t scanFrequency;
-  uint16_t bestFrequency;
+void scanTune( uint16_t frequency ) {
+  PROFILE_BEGIN(PROFILE_SETTLE);
+  receiver.setFrequency(frequency);
+  scanFrequency = frequency;
+  scanTuneTime = millis();
+  settleTuneCount = settleSampleCount = adcSampleCount(ADC_RSSI);
+  settleStableCount = 0;
+  settleFull = 0;
+}
 
-  // Skip forward to avoid detecting the current channel
-  scanFrequency = frequency + SCANNING_STEP;
-  if (!(scanFrequency % 2))
-    scanFrequency++;        // RTC6715 can only generate odd frequencies
-
-  // Coarse tuning
-  bestFrequency = scanFrequency;
-  for (i = 0; i < 60 && (scanRssi < RSSI_TRESHOLD); i++) {
-    if ( scanFrequency <= (FREQUENCY_MAX - SCANNING_STEP))
-      scanFrequency += SCANNING_STEP;
-    else
-      scanFrequency = FREQUENCY_MIN;
-    receiver.setFrequency(scanFrequency);
-    delay( RSSI_STABILITY_DELAY_MS );
-    scanRssi = averageAnalogRead(RSSI_PIN);
-    if (bestRssi < scanRssi) {
-      bestRssi = scanRssi;
-      bestFrequency = scanFrequency;
-    }
+//******************************************************************************
+//* function: scanSettled
+//*         : true when the RSSI after the last retune can be trusted. That is
+//*         : when the ring buffer of the sampler only holds samples taken
+//*         : after the retune and RSSI_SETTLE_COUNT consecutive filtered
+//*         : values agree within RSSI_SETTLE_TOLERANCE. Small steps settle
+//*         : far faster than the RSSI_STABILITY_DELAY_MS upper bound, which
+//*         : the first step of a scan always waits. The settle time of each
+//*         : step is counted in settleHistogram.
+//******************************************************************************
+bool scanSettled( void ) {
+  uint32_t elapsed = millis() - scanTuneTime;
+  uint8_t  count = adcSampleCount(ADC_RSSI);
+  uint16_t rssi;
+  bool     settled = false;
+
+  if (elapsed >= RSSI_STABILITY_DELAY_MS) {
+    elapsed = RSSI_STABILITY_DELAY_MS;
+    settled = true;
   }
-  // Fine tuning
-  scanFrequency = bestFrequency - SCANNING_STEP * 4;
-  bestRssi = 0;
-  for (i = 0; i < SCANNING_STEP * 4; i++, scanFrequency += 2) {
-    receiver.setFrequency(scanFrequency);
-    delay( RSSI_STABILITY_DELAY_MS );
-    scanRssi = averageAnalogRead(RSSI_PIN);
-    if (bestRssi < scanRssi) {
-      bestRssi = scanRssi;
-      bestFrequency = scanFrequency;
+  else if (!settleFull && count != settleSampleCount) {
+    settleSampleCount = count;
+    rssi = adcRead(ADC_RSSI);
+    if ((uint8_t)(count - settleTuneCount) > ADC_RING_SIZE) {
+      if (abs((int16_t)(rssi - settleLastRssi)) <= RSSI_SETTLE_TOLERANCE)
+        settleStableCount++;
+      else
+        settleStableCount = 0;
+      settled = (settleStableCount >= RSSI_SETTLE_COUNT);
     }
+    settleLastRssi = rssi;
   }
-  // Return the best frequency
-  receiver.setFrequency(bestFrequency);
-  return (bestFrequency);
+  if (settled) {
+    settleHistogram[elapsed]++;
+    PROFILE_END(PROFILE_SETTLE);
+  }
+  return settled;
 }
+
+#ifdef PRINT_SETTLE_TIMES
 //******************************************************************************
-//* function: averageAnalogRead
-//*         : used to read from an anlog pin
-//*         : returns an averaged value between (in theory) 0 and 1024
-//*         : this function is called often, so it is speed optimized
+//* function: printSettleTimes
+//*         : prints the number of steps that settled within each millisecond
 //******************************************************************************
-uint16_t averageAnalogRead( uint8_t pin)
-{
-  uint16_t rssi = 0;
-  uint8_t i = 32;
+void printSettleTimes( void ) {
+  uint8_t i;
 
-  for ( ; i ; i--) {
-    rssi += analogRead(pin);
+  Serial.begin(115200);
+  Serial.print(F("settle ms:"));
+  for (i = 0; i <= RSSI_STABILITY_DELAY_MS; i++) {
+    Serial.print(' ');
+    Serial.print(settleHistogram[i]);
   }
-  return (rssi >> 5);
+  Serial.println();
 }
+#endif
 
 //******************************************************************************
-//* function: shortNameOfChannel
+//* function: scanFinish
+//*         : leaves the receiver on the best frequency and shows the closest
+//*         : channel
 //******************************************************************************
-char *shortNameOfChannel(uint8_t channel, char *name)
-{
-  uint8_t channelIndex = getPosition(channel);
-  if (channelIndex < 8)
-    name[0] = 'A';
-  else if (channelIndex < 16)
-    name[0] = 'B';
-  else if (channelIndex < 24)
-    name[0] = 'E';
-  else if (channelIndex < 32)
-    name[0] = 'F';
-  else if (channelIndex < 40)
-    name[0] = 'C';
-  else
-    name[0] = 'L';
-  name[1] = (channelIndex % 8) + '0' + 1;
-  name[2] = 0;
-  return name;
+void scanFinish( uint16_t frequency ) {
+  scanMode = SCAN_IDLE;
+  receiver.setFrequency(frequency);
+  currentChannel = channelNearest(frequency);
+  drawChannelScreen(currentChannel, 0);
+  schedulerStart(refreshTask, RSSI_STABILITY_DELAY_MS);
+  schedulerStart(screenSaverTask, SAVE_SCREEN_DELAY_MS);
 }
 
 //******************************************************************************
-//* function: longNameOfChannel
+//* function: scanCancel
+//*         : returns to the channel that was active before the scan
 //******************************************************************************
-char *longNameOfChannel(uint8_t channel, char *name)
-{
-  uint8_t len;
-  uint8_t channelIndex = getPosition(channel);
-  if (channelIndex < 8)
-    strcpy(name, "Boscam A");
-  else if (channelIndex < 16)
-    strcpy(name, "Boscam B");
-  else if (channelIndex < 24)
-    strcpy(name, "Foxtech/DJI ");
-  else if (channelIndex < 32)
-    strcpy(name, "FatShark ");
-  else if (channelIndex < 40)
-    strcpy(name, "Raceband ");
-  else
-    strcpy(name, "Lowband  ");
-  len = strlen( name );
-  name[len] = (channelIndex % 8) + '0' + 1;
-  name[len + 1] = 0;
-  return name;
+void scanCancel( void ) {
+  if (scanMode == SCAN_WATERFALL)
+    scrollDisplay(0);
+  scanMode = SCAN_IDLE;
+  receiver.setFrequency(channelFrequency(currentChannel));
+  drawChannelScreen(currentChannel, 0);
+  schedulerStart(refreshTask, RSSI_STABILITY_DELAY_MS);
+  schedulerStart(screenSaverTask, SAVE_SCREEN_DELAY_MS);
 }
 
 //******************************************************************************
-//* function: getVoltage
-//*         : returns battery voltage as a uint16_t integer
-//*         : The value is multiplied with 10, 12volts => 120, 7.2Volts => 72
-//*
-//*         : Measured voltage values:
-//*         : 12.6v = 639   10.8v = 546   8.4v = 411   7.2v = 359
-//*         : The result is not linear...
-//*         : A rough estimation is that 5 steps correspond to 0.1 volts
+//* function: scanTick
+//*         : advances the scan engine, returns at once if the RSSI of the
+//*         : current step has not settled yet
 //******************************************************************************
-uint16_t getVoltage( void )
-{
-  return ( 50 + (((averageAnalogRead(VOLTAGE_METER_PIN) - 250 + (options[BATTERY_CALIB_OPTION] - 128))) / 5 ));
+void scanTick( void ) {
+  uint8_t  pressed;
+  uint16_t frequency;
+  uint16_t rssi;
+
+  if (scanMode == SCAN_IDLE)
+    return;
+
+  // Act on the button press itself instead of waiting for the click
+  pressed = buttonDown();
+  if (pressed && !scanButtonDown) {
+    scanButtonDown = 1;
+    swallowClick = 1;
+    if (scanMode == SCAN_GRAPHIC)
+      scanStartFine(scanShownFrequency);
+    else
+      scanCancel();
+    return;
+  }
+  scanButtonDown = pressed;
+
+  if (!scanSettled())
+    return;
+
+  frequency = scanFrequency;
+  rssi = adcRead(ADC_RSSI);
+
+  switch (scanMode) {
+    case SCAN_GRAPHIC:
+    case SCAN_WATERFALL:
+#ifdef STREAM_SPECTRUM
+      streamSample(frequency, rssi);
+#endif
+      // Retune first, then render while the next step settles
+      if (frequency + SCANNING_STEP > FREQUENCY_MAX) {
+        scanTune(FREQUENCY_MIN);
+        scanSweepTime = millis() - scanSweepStart;
+        scanSweepStart = millis();
+        spectrumSweepDone();
+        noiseLearn();
+#ifdef STREAM_SPECTRUM
+        streamSweep(FREQUENCY_MIN, FREQUENCY_MAX, SCANNING_STEP);
+#endif
+#ifdef PRINT_SETTLE_TIMES
+        printSettleTimes();
+#endif
+      }
+      else
+        scanTune(frequency + SCANNING_STEP);
+      scanShownFrequency = frequency;
+      spectrumStore(frequency, rssi);
+      if (scanMode == SCAN_GRAPHIC)
+        updateScannerScreen(spectrumColumn(frequency));
+      else if (scanFrequency == FREQUENCY_MIN)
+        updateWaterfallScreen();      // The sweep is complete
+      break;
+
+    case SCAN_AUTO:
+      spectrumStore(frequency, rssi);
+      // The first step tells if the search starts on a signal. Its skirt
+      // is passed over: the search is armed once the RSSI has dropped below
+      // the leave level, and the fine scan starts from the next signal
+      // found. If the RSSI climbs from the start instead, the signal lies
+      // ahead and is taken at its top. The best sample is otherwise only
+      // used when the search gives up.
+      if (rssi < (scanStep ? noiseLeave() : noiseEnter()))
+        scanArmed = 1;
+      if (scanBestRssi < rssi) {
+        scanBestRssi = rssi;
+        scanBestFrequency = frequency;
+      }
+      if (scanArmed && rssi >= noiseEnter())
+        scanStartFine(frequency);
+      else if (!scanArmed && rssi < scanBestRssi && scanBestFrequency != scanShownFrequency)
+        scanStartFine(scanBestFrequency);
+      else if (++scanStep >= AUTO_SCAN_MAX_STEPS) {
+        noiseLearn();
+        scanStartFine(scanBestFrequency);
+      }
+      else if (frequency <= (FREQUENCY_MAX - SCANNING_STEP))
+        scanTune(frequency + SCANNING_STEP);
+      else
+        scanTune(FREQUENCY_MIN);
+      break;
+
+    case SCAN_FINE:
+      fineRssi[scanStep] = rssi;
+      if (scanBestRssi < rssi) {
+        scanBestRssi = rssi;
+        scanBestFrequency = frequency;
+      }
+      if (++scanStep == 3) {
+        // Probe the top of the parabola through the three samples, unless
+        // it coincides with one of them
+        fineFrequency[3] = (fineFrequency[0] + parabolaOffset(fineRssi[1], fineRssi[0], fineRssi[2], FINE_TUNE_SPAN)) | 1;
+        if (fineFrequency[3] == fineFrequency[0] || fineFrequency[3] == fineFrequency[1] || fineFrequency[3] == fineFrequency[2])
+          scanStep = FINE_TUNE_PROBES;
+      }
+      if (scanStep >= FINE_TUNE_PROBES)
+        scanFinish(scanBestFrequency);
+      else
+        scanTune(fineFrequency[scanStep]);
+      break;
+  }
 }
+
 //******************************************************************************
 //* function: batteryMeter
 //******************************************************************************
 void batteryMeter( void )
 {
-  uint16_t voltage;
-  uint8_t value;
-  uint16_t minV;
-  uint16_t maxV;
-
-  if (options[BATTERY_TYPE_OPTION])
-  { /* 2s lipo battery*/
-    minV = 68;
-    maxV = 84;
-  }
-  else
-  { /* 3s lipo battery */
-    minV = 102;
-    maxV = 126;
-  }
-  voltage = getVoltage();
-
-  if (voltage >= maxV)
-    value = 99;
-  else if (voltage <= minV)
-    value = 0;
-  else
-    value = (uint8_t)((voltage - minV) / (float)(maxV - minV) * 100.0);
-
-  // Set alarm periods
-  if (value < 5)
-  {
-    alarmOnPeriod = ALARM_MAX_ON;
-    alarmOffPeriod = ALARM_MAX_OFF;
-  }
-  else if (value < 15)
-  {
-    alarmOnPeriod = ALARM_MED_ON;
-    alarmOffPeriod = ALARM_MED_OFF;
-  }
-  else if (value < 25)
-  {
-    alarmOnPeriod = ALARM_MIN_ON;
-    alarmOffPeriod = ALARM_MIN_OFF;
-  }
-  else
-  {
-    alarmOnPeriod = 0;
-    alarmOffPeriod = 0;
-  }
-  drawBattery(58, 32, value);
+  drawBattery(58, 32, batteryLevel());
 }
 
 //******************************************************************************
-//* function: updateSoftPositions
+//* function: sampleBattery
+//*         : task, passes the battery voltage to the battery model and sets
+//*         : the alarm periods of its alarm stage
 //******************************************************************************
-void updateSoftPositions( void ) {
-  uint8_t i;
-
-  // Mark blocked channels in the softPositions array
-  for (i = 0; i < 48; i++)
-    softPositions[i] = positions[i];
-
-  if (!options[A_BAND_OPTION]) {
-    for (i = 0; i < 8; i++)
-      softPositions[getReversePosition( i )] = 255;
-  }
-  if (!options[B_BAND_OPTION]) {
-    for (i = 8; i < 16; i++)
-      softPositions[getReversePosition( i )] = 255;
-  }
-  if (!options[E_BAND_OPTION]) {
-    for (i = 16; i < 24; i++)
-      softPositions[getReversePosition( i )] = 255;
-  }
-  if (!options[F_BAND_OPTION]) {
-    for (i = 24; i < 32; i++)
-      softPositions[getReversePosition( i )] = 255;
-  }
-  if (!options[R_BAND_OPTION]) {
-    for (i = 32; i < 40; i++)
-      softPositions[getReversePosition( i )] = 255;
-  }
-  if (!options[L_BAND_OPTION]) {
-    for (i = 40; i < 48; i++)
-      softPositions[getReversePosition( i )] = 255;
+void sampleBattery( void )
+{
+  batteryUpdate(adcRead(ADC_VOLTAGE), options[BATTERY_CALIB_OPTION], options[BATTERY_TYPE_OPTION] ? 2 : 3);
+
+  switch (batteryAlarm()) {
+    case BATTERY_ALARM_EMPTY:
+      alarmOnPeriod = ALARM_MAX_ON;
+      alarmOffPeriod = ALARM_MAX_OFF;
+      // Power may be lost at any moment, finish saving the settings
+      eepromQueueFlush();
+      break;
+    case BATTERY_ALARM_LOWER:
+      alarmOnPeriod = ALARM_MED_ON;
+      alarmOffPeriod = ALARM_MED_OFF;
+      break;
+    case BATTERY_ALARM_LOW:
+      alarmOnPeriod = ALARM_MIN_ON;
+      alarmOffPeriod = ALARM_MIN_OFF;
+      break;
+    default:
+      alarmOnPeriod = 0;
+      alarmOffPeriod = 0;
+      break;
   }
 }
 
 //******************************************************************************
-//* function: resetOptions
-//*         : Resets all configuration settings to their default values
+//* function: updateBands
+//*         : passes the band options on to the channel model
 //******************************************************************************
+void updateBands( void ) {
+  uint8_t bands = 0;
+  uint8_t i;
+
+  for (i = 0; i < 6; i++)
+    if (options[A_BAND_OPTION + i])
+      bands |= 1 << i;
+  // Bands added to the band plan have no option and are always enabled
+  channelSetBands(bands | (BAND_ALL & ~0x3F));
+}
 
 //******************************************************************************
 //* function: resetOptions
@@ -735,7 +972,7 @@ void resetOptions(void) {
   options[R_BAND_OPTION]           = R_BAND_DEFAULT;
   options[L_BAND_OPTION]           = L_BAND_DEFAULT;
 
-  updateSoftPositions();
+  updateBands();
 }
 
 //******************************************************************************
@@ -751,13 +988,17 @@ void setOptions()
   // Display option screen
   drawOptionsScreen( menuSelection, in_edit_state );
 
-  // Let the user release the button
-  getClickType( BUTTON_PIN );
+  // Drop a click made before the screen was shown
+  buttonClick();
 
   while ( !exitNow )
   {
     drawOptionsScreen( menuSelection, in_edit_state );
-    click = getClickType( BUTTON_PIN );
+    schedulerRun();
+    // On/off options toggle on every click, a double click means nothing
+    buttonInstant(INSTANT_CLICKS && in_edit_state &&
+                  menuSelection != ALARM_LEVEL_OPTION && menuSelection != BATTERY_CALIB_OPTION);
+    click = buttonClick();
 
     if (in_edit_state)
       switch ( click )
@@ -832,25 +1073,67 @@ void setOptions()
           break;
       }
   }
-  updateSoftPositions();
+  buttonInstant(false);
+  updateBands();
 }
 
 //******************************************************************************
 //* function: testAlarm
-//*         : Cycles through alarms, regardless of alarm settings
+//*         : sounds the alarm at the fastest rate, regardless of alarm
+//*         : settings, until the button is clicked. The alarm task does the
+//*         : switching, so the other tasks keep running.
 //******************************************************************************
 void testAlarm( void ) {
-  uint8_t i;
+  alarmTest = 1;
+  alarmSoundOn = 0;
+  schedulerStart(alarmTask, 0);
+  buttonInstant(INSTANT_CLICKS);
+  while (buttonClick() == NO_CLICK) {
+    schedulerRun();
+    idleSleep();
+  }
+  buttonInstant(false);
 
-  while (getClickType(BUTTON_PIN) == NO_CLICK) {
-    for (i = 0; i < 3; i++) {
-      analogWrite( ALARM_PIN, 1 << options[ALARM_LEVEL_OPTION] - 1 );
-      delay(ALARM_MAX_ON);
-      analogWrite( ALARM_PIN, 0 );
-      delay(ALARM_MAX_OFF);
+  // Back to the battery alarm, which starts silent
+  alarmTest = 0;
+  alarmSoundOn = 1;
+  schedulerStart(alarmTask, 0);
+}
+
+#ifdef PROFILE_PHASES
+//******************************************************************************
+//* function: showDiagnostics
+//*         : shows the phase profiler statistics. Single click shows the next
+//*         : page, double click dumps the samples to the serial port and
+//*         : restarts the statistics, long click exits.
+//******************************************************************************
+void showDiagnostics( void ) {
+  uint8_t  page = 0;
+  uint8_t  click;
+  uint32_t redrawStart = 0;
+  bool     redraw = true;
+
+  for (;;) {
+    if (redraw || millis() - redrawStart >= 250) {
+      drawDiagnosticsScreen( page );
+      redrawStart = millis();
+      redraw = false;
+    }
+    schedulerRun();
+    click = buttonClick();
+    if (click == SINGLE_CLICK)
+      page = (page + 1) % DIAGNOSTICS_PAGES;
+    else if (click == DOUBLE_CLICK) {
+      profileDump();
+      profileReset();
     }
+    else if (click == LONG_CLICK)
+      break;
+    if (click != NO_CLICK)
+      redraw = true;
   }
 }
+#endif
 
 //******************************************************************************
 //* function: selectFunction
@@ -862,11 +1145,17 @@ uint8_t selectFunction(void)
   do
   {
     drawFunctionScreen( function );
-    lastClick = getClickType( BUTTON_PIN );
+    schedulerRun();
+    lastClick = buttonClick();
     if (lastClick == SINGLE_CLICK)
-      function == 3 ? function = 0 : function++;
-    if (lastClick == DOUBLE_CLICK)
-      function == 0 ? function = 3 : function--;
+      function == 4 ? function = 0 : function++;
+    if (lastClick == DOUBLE_CLICK) {
+#ifdef PROFILE_PHASES
+      if (function == 0)
+        return 5;                // Hidden diagnostics screen
+#endif
+      function == 0 ? function = 4 : function--;
+    }
   }
   while ( lastClick != LONG_CLICK );
   return ( function );
@@ -875,6 +1164,16 @@ uint8_t selectFunction(void)
 //******************************************************************************
 //* Screen functions
 //******************************************************************************
+//******************************************************************************
+//* function: flushDisplay
+//*         : sends the framebuffer to the display
+//******************************************************************************
+void flushDisplay( void ) {
+  PROFILE_BEGIN(PROFILE_FLUSH);
+  display.display();
+  PROFILE_END(PROFILE_FLUSH);
+}
+
 //******************************************************************************
 //* function: dissolveDisplay
 //*         : fancy graphics stuff that dissolves the screen into black
@@ -882,10 +1181,15 @@ uint8_t selectFunction(void)
 //******************************************************************************
 void dissolveDisplay(void)
 {
+  channelScreenShown = 0;
   uint8_t x, y, i = 30;
   uint16_t j;
+#ifdef SH1106_PAGE_BUFFER
+  // Every pixel would be an item of the display list
+  i = 0;
+#endif
   while (i--) {
-    if (digitalRead(BUTTON_PIN) == BUTTON_PRESSED) // Return if button pressed
+    if (buttonDown()) // Return if button pressed
       return;
     j = 250;
     while (j--) {
@@ -893,10 +1197,11 @@ void dissolveDisplay(void)
       y = random(64);
       display.drawPixel( x, y, BLACK);
     }
-    display.display();
+    flushDisplay();
+    schedulerRun();
   }
   display.clearDisplay();
-  display.display();
+  flushDisplay();
 }
 
 //******************************************************************************
@@ -906,6 +1211,8 @@ void dissolveDisplay(void)
 void drawStartScreen( void ) {
   uint8_t i;
 
+  channelScreenShown = 0;
+  PROFILE_BEGIN(PROFILE_DRAW_START);
   display.clearDisplay();
   display.drawLine(0, 0, 127, 0, WHITE);
   display.setTextColor(WHITE);
@@ -918,13 +1225,15 @@ void drawStartScreen( void ) {
   display.print(F(VER_INFO_STRING));
   display.setCursor(33, 50);
   display.print(F(VER_DATE_STRING));
-  display.display();
+  flushDisplay();
+  PROFILE_END(PROFILE_DRAW_START);
 
   // Return after 2000 ms or when button is pressed
   for (i = 200; i; i--)
   {
-    if (digitalRead(BUTTON_PIN) == BUTTON_PRESSED )
+    if (buttonDown())
       return;
+    schedulerRun();
     delay(10);
   }
   dissolveDisplay();
@@ -933,52 +1242,88 @@ void drawStartScreen( void ) {
 
 //******************************************************************************
 //* function: drawChannelScreen
-//*         : draws the standard screen with channel information
+//*         : draws the standard screen with channel information. The fixed
+//*         : parts are only drawn when the screen is entered, after that only
+//*         : the fields whose value has changed are redrawn and sent.
 //******************************************************************************
 void drawChannelScreen( uint8_t channel, uint16_t rssi) {
   char buffer[22];
   uint8_t i;
+  bool changed = false;
 
-  display.clearDisplay();
+  PROFILE_BEGIN(PROFILE_DRAW_CHANNEL);
+  if (!channelScreenShown) {
+    display.clearDisplay();
+    display.setTextColor(WHITE);
+    display.setCursor(75, 7);
+    display.setTextSize(2);
+    display.print(F(" MHz"));
+    display.drawLine(0, 24, 127, 24, WHITE);
+    display.setCursor(0, 27);
+    display.setTextSize(1);
+    display.print(F("  Channel    RSSI"));
+    widgetInvalidate(&frequencyWidget);
+    widgetInvalidate(&nameWidget);
+    widgetInvalidate(&rssiWidget);
+    widgetInvalidate(&batteryWidget);
+    widgetInvalidate(&bandWidget);
+    widgetInvalidate(&averageWidget);
+    channelScreenShown = 1;
+    changed = true;
+  }
   display.setTextColor(WHITE);
-  display.setCursor(10, 0);
-  display.setTextSize(3);
-  display.print(getFrequency(channel));
-  display.setCursor(75, 7);
-  display.setTextSize(2);
-  display.print(F(" MHz"));
-  display.drawLine(0, 24, 127, 24, WHITE);
-  display.setCursor(0, 27);
-  display.setTextSize(1);
-  display.print(F("  Channel    RSSI"));
-  display.setCursor(0, 39);
-  display.setTextSize(2);
-  display.print(F(" "));
-  display.print(F(" "));
-  display.print(shortNameOfChannel(channel, buffer));
-  display.print(F("  "));
-  display.print(rssi);
-  display.setCursor(0, 57);
-  display.setTextSize(1);
-  longNameOfChannel(channel, buffer);
-  i = (21 - strlen(buffer)) / 2;
-  for (; i; i--) {
-    display.print(F(" "));
+  if (widgetUpdate(&display, &frequencyWidget, channelFrequency(channel))) {
+    display.print(channelFrequency(channel));
+    changed = true;
   }
-  display.print( buffer );
-  batteryMeter();
-  display.display();
+  if (widgetUpdate(&display, &nameWidget, channel)) {
+    display.print(channelShortName(channel, buffer));
+    changed = true;
+  }
+  if (widgetUpdate(&display, &rssiWidget, rssi)) {
+    display.print(rssi);
+    changed = true;
+  }
+  if (widgetUpdate(&display, &bandWidget, channel)) {
+    channelLongName(channel, buffer);
+    i = (21 - strlen(buffer)) / 2;
+    for (; i; i--) {
+      display.print(F(" "));
+    }
+    display.print( buffer );
+    changed = true;
+  }
+  if (widgetUpdate(&display, &batteryWidget, batteryLevel())) {
+    batteryMeter();
+    changed = true;
+  }
+  // A bar under the RSSI for the average the scanners have seen, full
+  // width at the learned ceiling
+  i = noiseLevel(spectrumRssi(channelFrequency(channel)));
+  if (i > NOISE_LEVEL_CEILING)
+    i = NOISE_LEVEL_CEILING;
+  i = i * averageWidget.width / NOISE_LEVEL_CEILING;
+  if (widgetUpdate(&display, &averageWidget, i)) {
+    if (i)
+      display.fillRect(averageWidget.x, averageWidget.y, i, averageWidget.height, WHITE);
+    changed = true;
+  }
+  if (changed)
+    flushDisplay();
+  PROFILE_END(PROFILE_DRAW_CHANNEL);
 }
 
 //******************************************************************************
 //* function: drawFunctionScreen
 //******************************************************************************
 #define XPOS  14
-#define YPOS  14
-uint8_t drawFunctionScreen( uint8_t function )
+#define YPOS  9
+void drawFunctionScreen( uint8_t function )
 {
-  display.fillRect(9, 9, 110, 46, BLACK);
-  display.drawRect(10, 10, 108, 44, WHITE);
+  channelScreenShown = 0;
+  PROFILE_BEGIN(PROFILE_DRAW_FUNCTION);
+  display.fillRect(9, 4, 110, 56, BLACK);
+  display.drawRect(10, 5, 108, 54, WHITE);
   display.setTextSize(1);
   display.setCursor(XPOS, YPOS);
   display.setTextColor(function == 0 ? BLACK : WHITE, function == 0 ? WHITE : BLACK);
@@ -991,8 +1336,12 @@ uint8_t drawFunctionScreen( uint8_t function )
   display.print(F(" Auto Scanner    "));
   display.setCursor(XPOS, YPOS + 27);
   display.setTextColor(function == 3 ? BLACK : WHITE, function == 3 ? WHITE : BLACK);
+  display.print(F(" Waterfall       "));
+  display.setCursor(XPOS, YPOS + 36);
+  display.setTextColor(function == 4 ? BLACK : WHITE, function == 4 ? WHITE : BLACK);
   display.print(F(" Options         "));
-  display.display();
+  flushDisplay();
+  PROFILE_END(PROFILE_DRAW_FUNCTION);
 }
 
 //******************************************************************************
@@ -1000,6 +1349,8 @@ uint8_t drawFunctionScreen( uint8_t function )
 //******************************************************************************
 void drawAutoScanScreen( void )
 {
+  channelScreenShown = 0;
+  PROFILE_BEGIN(PROFILE_DRAW_AUTOSCAN);
   display.clearDisplay();
   display.setTextColor(WHITE);
   display.setCursor(10, 0);
@@ -1013,14 +1364,21 @@ void drawAutoScanScreen( void )
   display.setTextSize(1);
   display.print(F("  Channel    RSSI"));
   batteryMeter();
-  display.display();
+  flushDisplay();
+  PROFILE_END(PROFILE_DRAW_AUTOSCAN);
 }
 
 //******************************************************************************
 //* function: drawScannerScreen
+//*         : draws the frame and the spectrum that is already stored
 //******************************************************************************
 void drawScannerScreen( void ) {
+#ifndef SH1106_PAGE_BUFFER
+  uint8_t i;
+#endif
 
+  channelScreenShown = 0;
+  PROFILE_BEGIN(PROFILE_DRAW_SCANNER);
   display.clearDisplay();
   display.drawLine(0, 55, 127, 55, WHITE);
   display.setTextColor(WHITE);
@@ -1030,36 +1388,156 @@ void drawScannerScreen( void ) {
     display.print(F("5.35     5.6     5.95"));
   else
     display.print(F("5.65     5.8     5.95"));
-  updateScannerScreen(0, 0);
+  scannerCursor = 0;
+#ifdef SH1106_PAGE_BUFFER
+  display.drawLayer(14, 0, SPECTRUM_COLUMNS, 54, scannerLayer);
+#else
+  for (i = 0; i < SPECTRUM_COLUMNS; i++)
+    drawScannerColumn(i);
+#endif
+  flushDisplay();
+  PROFILE_END(PROFILE_DRAW_SCANNER);
+}
+
+//******************************************************************************
+//* function: rssiToBarHeight
+//*         : maps an RSSI value to a bar height of 0 to 53 pixels. The
+//*         : learned floor is at 0 and the ceiling at 46, which leaves room
+//*         : above it for a stronger signal.
+//******************************************************************************
+uint8_t rssiToBarHeight( uint16_t rssi ) {
+  uint16_t bar = ((uint16_t)noiseLevel(rssi) * 46) / NOISE_LEVEL_CEILING;
+
+  return bar > 53 ? 53 : bar;
 }
 
+//******************************************************************************
+//* function: drawScannerColumn
+//*         : draws one column of the stored spectrum, the latest value as a
+//*         : bar and the peak hold value as a dot above it
+//******************************************************************************
+void drawScannerColumn( uint8_t column ) {
+  uint8_t x = column + 14;   // The scan graph uses the 100 middle positions
+#ifdef SH1106_PAGE_BUFFER
+  // The column is rendered by scannerLayer when the display is flushed
+  display.drawLayer(x, 0, 1, 54, scannerLayer);
+#else
+  uint8_t bar = rssiToBarHeight((uint16_t)spectrumCurrent(column) << 2);
+  uint8_t peak = rssiToBarHeight((uint16_t)spectrumPeak(column) << 2);
+
+  display.drawFastVLine(x, 0, 54 - bar, BLACK);
+  if (bar)
+    display.drawFastVLine(x, 54 - bar, bar, WHITE);
+  if (peak > bar)
+    display.drawPixel(x, 54 - peak, WHITE);
+#endif
+}
+
+#ifdef SH1106_PAGE_BUFFER
+//******************************************************************************
+//* function: scannerLayer
+//*         : one byte of the scan graph for the page buffer display: the bar,
+//*         : the peak hold dot and the scan line of drawScannerColumn and
+//*         : updateScannerScreen. Rows below the graph are masked off.
+//******************************************************************************
+uint8_t scannerLayer( uint8_t x, uint8_t page ) {
+  uint8_t column = x - 14;
+  uint8_t top = page * 8;
+  uint8_t bar, peak, row;
+  uint8_t bits = 0;
+
+  if (column == scannerCursor)
+    return 0xFF;
+  bar = rssiToBarHeight((uint16_t)spectrumCurrent(column) << 2);
+  peak = rssiToBarHeight((uint16_t)spectrumPeak(column) << 2);
+  row = 54 - bar;
+  if (bar && row < top + 8)
+    bits = 0xFF << (row > top ? row - top : 0);
+  row = 54 - peak;
+  if (peak > bar && row >= top && row < top + 8)
+    bits |= 1 << (row - top);
+  return bits;
+}
+#endif
+
 //******************************************************************************
 //* function: updateScannerScreen
-//*         : position = 0 to 99
-//*         : value = 0 to 53
+//*         : redraws a column that has a new value and moves the scan line
+//*         : to the column after it
 //*         : must be fast since there are frequent updates
 //******************************************************************************
-void updateScannerScreen(uint8_t position, uint8_t value ) {
-  // uint8_t i;
-  static uint8_t last_position = 14;
-  static uint8_t last_value = 0;
+void updateScannerScreen( uint8_t column ) {
+  if (column >= SPECTRUM_COLUMNS)
+    return;
+
+  PROFILE_BEGIN(PROFILE_UPDATE_SCANNER);
+  // Restore the column under the scan line from the last pass
+  drawScannerColumn(scannerCursor);
+  drawScannerColumn(column);
+
+  // Draw the scan line where the next value will appear
+  scannerCursor = column + 1 < SPECTRUM_COLUMNS ? column + 1 : 0;
+#ifdef SH1106_PAGE_BUFFER
+  drawScannerColumn(scannerCursor);
+#else
+  display.drawFastVLine(scannerCursor + 14, 0, 54, WHITE);
+#endif
+  flushDisplay();
+  PROFILE_END(PROFILE_UPDATE_SCANNER);
+}
 
-  // The scan graph only uses the 100 positions in the middle of the screen
-  position = position + 14;
+//******************************************************************************
+//* function: drawWaterfallScreen
+//*         : clears the display for an empty waterfall. The waterfall fills
+//*         : the whole display, since the start line scrolls all of it.
+//******************************************************************************
+void drawWaterfallScreen( void ) {
+  channelScreenShown = 0;
+  PROFILE_BEGIN(PROFILE_DRAW_SCANNER);
+  display.clearDisplay();
+  waterfallBegin(waterfallHistory, sizeof(waterfallHistory) / WATERFALL_ROW_BYTES);
+#ifdef SH1106_PAGE_BUFFER
+  display.drawLayer(14, 0, SPECTRUM_COLUMNS, WATERFALL_LINES, waterfallLayer);
+#endif
+  flushDisplay();
+  scrollDisplay(waterfallStartLine(display.getRotation() == 2));
+  PROFILE_END(PROFILE_DRAW_SCANNER);
+}
 
-  // Errase the scan line from the last pass
-  display.drawFastVLine( last_position, 0, 54 - last_value, BLACK );
+#ifdef SH1106_PAGE_BUFFER
+//******************************************************************************
+//* function: waterfallLayer
+//*         : one byte of the waterfall for the page buffer display
+//******************************************************************************
+uint8_t waterfallLayer( uint8_t x, uint8_t page ) {
+  return waterfallBits(x - 14, page);
+}
+#endif
 
-  // Draw the current scan line
-  display.drawFastVLine( position, 0, 54, WHITE );
+//******************************************************************************
+//* function: updateWaterfallScreen
+//*         : adds the sweep that is complete as the top row. Only the bytes
+//*         : of that row are sent, the rows below move down when the start
+//*         : line of the display follows.
+//******************************************************************************
+void updateWaterfallScreen( void ) {
+  uint8_t line;
+#ifndef SH1106_PAGE_BUFFER
+  uint8_t column;
+#endif
 
-  // Save position and value for the next pass
-  last_position = position;
-  if (value > 53)
-    last_value = 53;
-  else
-    last_value = value;
-  display.display();
+  PROFILE_BEGIN(PROFILE_UPDATE_WATERFALL);
+  waterfallAdd();
+  line = waterfallLine();
+#ifdef SH1106_PAGE_BUFFER
+  display.drawLayer(14, line, SPECTRUM_COLUMNS, 1, waterfallLayer);
+#else
+  for (column = 0; column < SPECTRUM_COLUMNS; column++)
+    display.drawPixel(column + 14, line, waterfallDot(column, line, waterfallLevel(0, column)) ? WHITE : BLACK);
+#endif
+  flushDisplay();
+  scrollDisplay(waterfallStartLine(display.getRotation() == 2));
+  PROFILE_END(PROFILE_UPDATE_WATERFALL);
 }
 
 //******************************************************************************
@@ -1102,9 +1580,11 @@ void drawOption(uint8_t option)
   }
   else if ( option == BATTERY_CALIB_OPTION )
   {
-    display.print(getVoltage() / 10);
+    uint16_t voltage = (batteryMillivolts() + 50) / 100;
+
+    display.print(voltage / 10);
     display.print(F("."));
-    display.print(getVoltage() % 10);
+    display.print(voltage % 10);
   }
   else if (option == TEST_ALARM_COMMAND || option == RESET_SETTINGS_COMMAND || option == EXIT_COMMAND )
   {
@@ -1121,6 +1601,9 @@ void drawOption(uint8_t option)
 
 void drawOptionsScreen(uint8_t option, uint8_t in_edit_state ) {
   uint8_t i, j;
+
+  channelScreenShown = 0;
+  PROFILE_BEGIN(PROFILE_DRAW_OPTIONS);
   if ( in_edit_state ) {
     display.setCursor( 17 * 6, 1 * 8 );
     display.setTextColor(BLACK, WHITE);
@@ -1171,7 +1654,62 @@ void drawOptionsScreen(uint8_t option, uint8_t in_edit_state ) {
       display.println();
     }
   }
-  display.display();
+  flushDisplay();
+  PROFILE_END(PROFILE_DRAW_OPTIONS);
+}
+
+#ifdef PROFILE_PHASES
+//******************************************************************************
+//* function: drawDiagnosticsScreen
+//*         : draws min, mean and max in microseconds for one page of phases
+//******************************************************************************
+void drawDiagnosticsScreen( uint8_t page ) {
+  char    name[7];
+  uint8_t phase, y;
+
+  channelScreenShown = 0;
+  display.clearDisplay();
+  display.setTextColor(WHITE);
+  display.setTextSize(1);
+  display.setCursor(0, 0);
+  display.print(F("us"));
+  display.setCursor(38, 0);
+  display.print(F("min"));
+  display.setCursor(68, 0);
+  display.print(F("mean"));
+  display.setCursor(98, 0);
+  display.print(F("max"));
+  display.drawLine(0, 9, 127, 9, WHITE);
+
+  y = 11;
+  for (phase = page * DIAGNOSTICS_ROWS; phase < PROFILE_COUNT && phase < (page + 1) * DIAGNOSTICS_ROWS; phase++, y += 8) {
+    display.setCursor(0, y);
+    display.print(profileName(phase, name));
+    if (!profileCount(phase))
+      continue;
+    display.setCursor(38, y);
+    display.print(profileMin(phase));
+    display.setCursor(68, y);
+    display.print(profileMean(phase));
+    display.setCursor(98, y);
+    display.print(profileMax(phase));
+  }
+  flushDisplay();
+}
+#endif
+
+//******************************************************************************
+//* function: scrollDisplay
+//*         : sets the line of the display RAM that is shown on top
+//******************************************************************************
+void scrollDisplay( uint8_t line )
+{
+#ifdef SSD1306_OLED_DRIVER
+  display.ssd1306_command(SSD1306_SETSTARTLINE | line);
+#endif
+#ifdef SH1106_OLED_DRIVER
+  display.SH1106_command(SH1106_SETSTARTLINE | line);
+#endif
 }
 
 //******************************************************************************
@@ -1179,8 +1717,38 @@ void drawOptionsScreen(uint8_t option, uint8_t in_edit_state ) {
 //******************************************************************************
 void activateScreenSaver( void)
 {
-  display.clearDisplay();
-  display.display();
+#ifdef SAVE_SCREEN_DIM
+  display.dim(true);
+#else
+#ifdef SSD1306_OLED_DRIVER
+  display.ssd1306_command(SSD1306_DISPLAYOFF);
+#endif
+#ifdef SH1106_OLED_DRIVER
+  display.SH1106_command(SH1106_DISPLAYOFF);
+#endif
+#endif
   saveScreenActive = 1;
+  buttonInstant(INSTANT_CLICKS);
+}
+
+//******************************************************************************
+//* function: deactivateScreenSaver
+//*         : restores the display and redraws the channel screen
+//******************************************************************************
+void deactivateScreenSaver( void )
+{
+#ifdef SAVE_SCREEN_DIM
+  display.dim(false);
+#else
+#ifdef SSD1306_OLED_DRIVER
+  display.ssd1306_command(SSD1306_DISPLAYON);
+#endif
+#ifdef SH1106_OLED_DRIVER
+  display.SH1106_command(SH1106_DISPLAYON);
+#endif
+#endif
+  saveScreenActive = 0;
+  buttonInstant(false);
+  schedulerStart(refreshTask, 0);
 }
 
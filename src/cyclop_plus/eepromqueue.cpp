@@ -0,0 +1,169 @@
+/*******************************************************************************
+  This file contains the EEPROM write queue. The EE_READY interrupt fires as
+  long as it is enabled and no programming cycle runs. The interrupt starts
+  the next write and disables itself when the queue is empty. On targets
+  other than AVR the writes are done at once through the EEPROM library.
+
+  The MIT License (MIT)
+
+  Copyright (c) 2017 Kjell Kernen (Dvogonen)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+********************************************************************************/
+// Application includes
+#include "Arduino.h"
+#include "eepromqueue.h"
+
+// Library includes
+#include <EEPROM.h>
+#ifdef __AVR__
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#endif
+
+#ifdef __AVR__
+//******************************************************************************
+//* File scope variables. The interrupt owns the tail, the main loop the head.
+
+static uint16_t         queueAddress[EEPROM_QUEUE_SIZE];
+static uint8_t          queueValue[EEPROM_QUEUE_SIZE];
+static volatile uint8_t queueHead = 0;
+static volatile uint8_t queueTail = 0;
+
+//******************************************************************************
+//* function: queueNext
+//******************************************************************************
+static inline uint8_t queueNext( uint8_t index )
+{
+  return index + 1 < EEPROM_QUEUE_SIZE ? index + 1 : 0;
+}
+
+//******************************************************************************
+//* function: ISR(EE_READY_vect)
+//*         : starts the programming of the next queued byte that differs
+//*         : from the EEPROM content
+//******************************************************************************
+ISR(EE_READY_vect)
+{
+  uint8_t tail = queueTail;
+
+  while (tail != queueHead) {
+    EEAR = queueAddress[tail];
+    EECR |= _BV(EERE);
+    if (EEDR != queueValue[tail]) {
+      EEDR = queueValue[tail];
+      EECR |= _BV(EEMPE);
+      EECR |= _BV(EEPE);
+      queueTail = queueNext(tail);
+      return;
+    }
+    tail = queueNext(tail);
+  }
+  queueTail = tail;
+  EECR &= ~_BV(EERIE);
+}
+#endif
+
+//******************************************************************************
+//* function: eepromQueueWrite
+//*         : queues a write, waits only if the queue is full
+//******************************************************************************
+void eepromQueueWrite( uint16_t address, uint8_t value )
+{
+#ifdef __AVR__
+  uint8_t head = queueHead;
+  uint8_t next = queueNext(head);
+
+  while (next == queueTail)
+    ;
+  queueAddress[head] = address;
+  queueValue[head] = value;
+  queueHead = next;
+  EECR |= _BV(EERIE);
+#else
+  EEPROM.update(address, value);
+#endif
+}
+
+//******************************************************************************
+//* function: eepromQueueRead
+//*         : reads a byte, the newest queued value if there is one
+//******************************************************************************
+uint8_t eepromQueueRead( uint16_t address )
+{
+#ifdef __AVR__
+  uint8_t index, value;
+  bool    done = false;
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    for (index = queueTail; index != queueHead; index = queueNext(index))
+      if (queueAddress[index] == address) {
+        value = queueValue[index];
+        done = true;
+      }
+  }
+  // The EEPROM can not be read during a programming cycle. Wait for it with
+  // interrupts on, then read before the interrupt can start the next one.
+  while (!done) {
+    while (EECR & _BV(EEPE))
+      ;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+      if (!(EECR & _BV(EEPE))) {
+        EEAR = address;
+        EECR |= _BV(EERE);
+        value = EEDR;
+        done = true;
+      }
+    }
+  }
+  return value;
+#else
+  return EEPROM.read(address);
+#endif
+}
+
+//******************************************************************************
+//* function: eepromQueuePending
+//*         : number of queued writes
+//******************************************************************************
+uint8_t eepromQueuePending( void )
+{
+#ifdef __AVR__
+  uint8_t head = queueHead;
+  uint8_t tail = queueTail;
+
+  return head >= tail ? head - tail : head + EEPROM_QUEUE_SIZE - tail;
+#else
+  return 0;
+#endif
+}
+
+//******************************************************************************
+//* function: eepromQueueFlush
+//*         : waits until all queued writes are programmed
+//******************************************************************************
+void eepromQueueFlush( void )
+{
+#ifdef __AVR__
+  while (queueTail != queueHead)
+    ;
+  while (EECR & _BV(EEPE))
+    ;
+#endif
+}
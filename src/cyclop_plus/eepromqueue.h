@@ -0,0 +1,42 @@
+/*******************************************************************************
+  This is the header file for the EEPROM write queue. Writes are queued at
+  once and programmed in the background from the EEPROM ready interrupt, one
+  byte per 3.4 ms programming cycle. Bytes that already hold the queued value
+  are skipped. Reads see queued values before they reach the EEPROM.
+
+  The MIT License (MIT)
+
+  Copyright (c) 2017 Kjell Kernen (Dvogonen)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+********************************************************************************/
+#ifndef eepromqueue_h
+#define eepromqueue_h
+
+#include "Arduino.h"
+
+// Number of writes that can wait, one settings record fits
+#define EEPROM_QUEUE_SIZE     24
+
+void    eepromQueueWrite( uint16_t address, uint8_t value );
+uint8_t eepromQueueRead( uint16_t address );
+uint8_t eepromQueuePending( void );
+void    eepromQueueFlush( void );
+
+#endif // eepromqueue_h
@@ -32,11 +32,20 @@ However, SH1106 driver don't provide several functions such as scroll commands.
 #endif
 #include <stdlib.h>
 
-#include <Wire.h>
-
 #include "Adafruit_GFX.h"
 #include "Adafruit_SH1106.h"
 
+#ifdef SH1106_TWI_ASYNC
+ #include <avr/interrupt.h>
+ #include <util/twi.h>
+#else
+ #include <Wire.h>
+#endif
+
+#ifdef SH1106_PAGE_BUFFER
+// a single page, rendered from the display list just before it is sent
+static uint8_t buffer[SH1106_LCDWIDTH];
+#else
 // the memory buffer for the LCD
 
 static uint8_t buffer[SH1106_LCDHEIGHT * SH1106_LCDWIDTH / 8] = { 
@@ -109,9 +118,558 @@ static uint8_t buffer[SH1106_LCDHEIGHT * SH1106_LCDWIDTH / 8] = {
 #endif
 #endif
 };
+#endif
+
+// dirty column range for each page, only these bytes are sent by display()
+// a page is clean when dirtyLo > dirtyHi
+#define SH1106_PAGES (SH1106_LCDHEIGHT / 8)
+static uint8_t dirtyLo[SH1106_PAGES];
+static uint8_t dirtyHi[SH1106_PAGES];
+
+static inline void markDirty(uint8_t page, uint8_t x0, uint8_t x1) {
+#ifdef SH1106_TWI_ASYNC
+  // the TWI interrupt clears the range when it starts sending a page
+  uint8_t sreg = SREG;
+  cli();
+#endif
+  if (x0 < dirtyLo[page]) dirtyLo[page] = x0;
+  if (x1 > dirtyHi[page]) dirtyHi[page] = x1;
+#ifdef SH1106_TWI_ASYNC
+  SREG = sreg;
+#endif
+}
+
+static void markAllDirty(void) {
+  for (uint8_t i = 0; i < SH1106_PAGES; i++) {
+    dirtyLo[i] = 0;
+    dirtyHi[i] = SH1106_LCDWIDTH - 1;
+  }
+}
+
+// the bytes of a column range of a page, as they are sent
+static inline uint8_t *pageData(uint8_t page, uint8_t x) {
+#ifdef SH1106_PAGE_BUFFER
+  return buffer + x;
+#else
+  return buffer + page * SH1106_LCDWIDTH + x;
+#endif
+}
+
+#if defined SH1106_FAST_TEXT || defined SH1106_PAGE_BUFFER
+// The 5x7 font of GFX, five bytes per character indexed by the character
+// code, one byte per column, LSB on top. Built from the same data that GFX
+// draws with, the link time optimisation can fold the two copies into one.
+#include <glcdfont.c>
+
+#ifdef SH1106_FAST_TEXT
+// Digits 0 to 9 of the font at text size 3, pre-rendered. Each font column
+// becomes three pages of 8 rows, every font row repeated three times.
+static const uint8_t fastDigits3[][5][3] PROGMEM = {
+  {{0xF8, 0xFF, 0x03}, {0x07, 0x70, 0x1C}, {0x07, 0x0E, 0x1C}, {0xC7, 0x01, 0x1C}, {0xF8, 0xFF, 0x03}},
+  {{0x00, 0x00, 0x00}, {0x38, 0x00, 0x1C}, {0xFF, 0xFF, 0x1F}, {0x00, 0x00, 0x1C}, {0x00, 0x00, 0x00}},
+  {{0x38, 0x00, 0x1C}, {0x07, 0x80, 0x1F}, {0x07, 0x70, 0x1C}, {0x07, 0x0E, 0x1C}, {0xF8, 0x01, 0x1C}},
+  {{0x07, 0x80, 0x03}, {0x07, 0x00, 0x1C}, {0xC7, 0x01, 0x1C}, {0x3F, 0x0E, 0x1C}, {0x07, 0xF0, 0x03}},
+  {{0x00, 0x7E, 0x00}, {0xC0, 0x71, 0x00}, {0x38, 0x70, 0x00}, {0xFF, 0xFF, 0x1F}, {0x00, 0x70, 0x00}},
+  {{0xFF, 0x81, 0x03}, {0xC7, 0x01, 0x1C}, {0xC7, 0x01, 0x1C}, {0xC7, 0x01, 0x1C}, {0x07, 0xFE, 0x03}},
+  {{0xC0, 0xFF, 0x03}, {0x38, 0x0E, 0x1C}, {0x07, 0x0E, 0x1C}, {0x07, 0x0E, 0x1C}, {0x00, 0xF0, 0x03}},
+  {{0x07, 0x00, 0x00}, {0x07, 0xF0, 0x1F}, {0x07, 0x0E, 0x00}, {0xC7, 0x01, 0x00}, {0x3F, 0x00, 0x00}},
+  {{0xF8, 0xF1, 0x03}, {0x07, 0x0E, 0x1C}, {0x07, 0x0E, 0x1C}, {0x07, 0x0E, 0x1C}, {0xF8, 0xF1, 0x03}},
+  {{0xF8, 0x01, 0x00}, {0x07, 0x0E, 0x1C}, {0x07, 0x0E, 0x1C}, {0x07, 0x8E, 0x03}, {0xF8, 0x7F, 0x00}}
+};
+#endif
+
+// a nibble with every bit doubled, used to stretch a font column to size 2
+static const uint8_t fastSpread[16] PROGMEM = {
+  0x00, 0x03, 0x0C, 0x0F, 0x30, 0x33, 0x3C, 0x3F,
+  0xC0, 0xC3, 0xCC, 0xCF, 0xF0, 0xF3, 0xFC, 0xFF
+};
+
+// a nibble with its bits in reverse order, for the 180 degree rotation
+static const uint8_t fastReverse[16] PROGMEM = {
+  0x0, 0x8, 0x4, 0xC, 0x2, 0xA, 0x6, 0xE,
+  0x1, 0x9, 0x5, 0xD, 0x3, 0xB, 0x7, 0xF
+};
+#endif
+
+#ifdef SH1106_FAST_TEXT
+static bool fastTextEnabled = true;
+#endif
+
+#ifdef SH1106_TWI_ASYNC
+// Interrupt driven I2C master. A flush is a chain of transactions joined by
+// repeated starts: for every dirty page one command transaction that sets the
+// page and column address, followed by one data transaction with the dirty
+// column range. The range is cleared when the page is picked up, so pixels
+// drawn while the page is on the bus are sent again by the next flush.
+#define TWI_IDLE       0
+#define TWI_COMMAND    1    // single command from SH1106_command
+#define TWI_PAGE_CMD   2    // page and column address of the current page
+#define TWI_PAGE_DATA  3    // dirty column range of the current page
+
+#define TWI_GO    (_BV(TWINT) | _BV(TWEN) | _BV(TWIE))
+
+static volatile uint8_t twiState = TWI_IDLE;
+static volatile uint8_t twiAgain = 0;   // display() was called during a flush
+static uint8_t  twiAddr;
+static uint8_t  twiPage;
+static uint8_t  twiControl;             // control byte sent after the address
+static uint8_t  twiIndex;
+static uint8_t  twiLen;
+static uint8_t *twiPtr;
+static uint8_t  twiCmd[3];
+static uint8_t *twiPageData;
+static uint8_t  twiPageLen;
+static uint8_t  twiPageEnd = SH1106_PAGES;  // pages from here on are left for later
+
+// Picks up the next dirty page at or after page and prepares its command
+// transaction. Returns false when there are no dirty pages left.
+static bool twiNextPage(uint8_t page) {
+  for (; page < twiPageEnd; page++) {
+    if (dirtyLo[page] > dirtyHi[page])
+      continue;
+    twiPage = page;
+    twiCmd[0] = 0xB0 + page;                  // set page address
+    twiCmd[1] = dirtyLo[page] & 0xf;          // set lower column address
+    twiCmd[2] = 0x10 | (dirtyLo[page] >> 4);  // set higher column address
+    twiPageData = pageData(page, dirtyLo[page]);
+    twiPageLen = dirtyHi[page] - dirtyLo[page] + 1;
+    dirtyLo[page] = 0xFF;
+    dirtyHi[page] = 0;
+
+    twiState = TWI_PAGE_CMD;
+    twiControl = 0x00;                        // Co = 0, D/C = 0
+    twiPtr = twiCmd;
+    twiLen = 3;
+    return true;
+  }
+  return false;
+}
+
+static void twiStart(void) {
+  // a stop condition from the previous transfer may still be pending
+  while (TWCR & _BV(TWSTO))
+    ;
+  TWCR = TWI_GO | _BV(TWSTA);
+}
+
+ISR(TWI_vect) {
+  switch (TW_STATUS) {
+    case TW_START:
+    case TW_REP_START:
+      TWDR = twiAddr << 1;                    // SLA+W
+      twiIndex = 0;
+      TWCR = TWI_GO;
+      return;
+
+    case TW_MT_SLA_ACK:
+    case TW_MT_DATA_ACK:
+      if (twiIndex == 0) {
+        TWDR = twiControl;
+        twiIndex++;
+        TWCR = TWI_GO;
+        return;
+      }
+      if (twiIndex <= twiLen) {
+        TWDR = twiPtr[twiIndex - 1];
+        twiIndex++;
+        TWCR = TWI_GO;
+        return;
+      }
+      // Transaction complete, chain the next one with a repeated start
+      if (twiState == TWI_PAGE_CMD) {
+        twiState = TWI_PAGE_DATA;
+        twiControl = 0x40;                    // Co = 0, D/C = 1
+        twiPtr = twiPageData;
+        twiLen = twiPageLen;
+        TWCR = TWI_GO | _BV(TWSTA);
+        return;
+      }
+      if (twiState == TWI_PAGE_DATA) {
+        if (twiNextPage(twiPage + 1)) {
+          TWCR = TWI_GO | _BV(TWSTA);
+          return;
+        }
+        if (twiAgain) {
+          twiAgain = 0;
+          if (twiNextPage(0)) {
+            TWCR = TWI_GO | _BV(TWSTA);
+            return;
+          }
+        }
+      }
+      break;
+
+    default:
+      // NACK, arbitration lost or bus error. Give up and let the next
+      // display() send the whole frame again.
+      markAllDirty();
+      twiAgain = 0;
+      break;
+  }
+  TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWSTO);
+  twiState = TWI_IDLE;
+}
+#endif
+
+// the rows of a rectangle that fall in a page, as a mask
+static uint8_t rowMask(uint8_t y, uint8_t h, uint8_t page) {
+  int16_t top = y - page * 8;
+  int16_t bottom = top + h - 1;
+  uint8_t mask = 0xFF;
+
+  if (bottom < 0 || top > 7)
+    return 0;
+  if (top > 0)
+    mask <<= top;
+  if (bottom < 7)
+    mask &= 0xFF >> (7 - bottom);
+  return mask;
+}
+
+static inline uint8_t reverseBits(uint8_t b) {
+  return (pgm_read_byte(&fastReverse[b & 0x0F]) << 4) | pgm_read_byte(&fastReverse[b >> 4]);
+}
+
+// Update one byte of a page: the bits in clear are cleared, then the bits
+// in set are set and the bits in toggle are inverted. x and the bits are
+// in the coordinates of the current rotation, flip is true for rotation 2.
+static void putBits(uint8_t *page, uint8_t x, uint8_t clear, uint8_t set, uint8_t toggle, bool flip) {
+  if (flip) {
+    x = SH1106_LCDWIDTH - 1 - x;
+    clear = reverseBits(clear);
+    set = reverseBits(set);
+    toggle = reverseBits(toggle);
+  }
+  page[x] = ((page[x] & ~clear) | set) ^ toggle;
+}
+
+// mark a rectangle in the coordinates of the current rotation dirty
+static void markRect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, bool flip) {
+  uint8_t x0 = x, x1 = x + w - 1;
+  uint8_t p0 = y / 8, p1 = (y + h - 1) / 8;
+
+  if (flip) {
+    x0 = SH1106_LCDWIDTH - 1 - x1;
+    x1 = SH1106_LCDWIDTH - 1 - x;
+    p0 = SH1106_PAGES - 1 - p1;
+    p1 = SH1106_PAGES - 1 - y / 8;
+  }
+  for (; p0 <= p1; p0++)
+    markDirty(p0, x0, x1);
+}
+
+// clip a rectangle to the screen, false if nothing is left
+static bool clipRect(int16_t *x, int16_t *y, int16_t *w, int16_t *h, int16_t width, int16_t height) {
+  if (*x < 0) { *w += *x; *x = 0; }
+  if (*y < 0) { *h += *y; *y = 0; }
+  if (*x + *w > width) *w = width - *x;
+  if (*y + *h > height) *h = height - *y;
+  return *w > 0 && *h > 0;
+}
+
+#ifdef SH1106_PAGE_BUFFER
+// The display list. Every item is a rectangle in the coordinates of the
+// current rotation that is filled with a color, a run of characters or the
+// output of a layer function. Items are rendered in order, later ones on
+// top, and an item that a new opaque one covers completely is dropped.
+#define ITEM_FILL     0x00    // bits 0-1 color
+#define ITEM_TEXT     0x40    // bit 0 color, bit 1 opaque, bits 2-3 size - 1
+#define ITEM_LAYER    0x80    // data is the layer number
+#define ITEM_TYPE     0xC0
+#define ITEM_OPAQUE   0x02
+
+struct displayItem {
+  uint8_t kind;
+  uint8_t x, y, w, h;
+  uint8_t data;               // first character of a run in textPool
+};
+
+static displayItem  items[SH1106_LIST_ITEMS];
+static uint8_t      itemCount;
+static char         textPool[SH1106_LIST_CHARS];
+static uint8_t      textUsed;
+static SH1106_Layer layers[SH1106_LIST_LAYERS];
+static uint8_t      itemPeak, textPeak;
+
+static inline uint8_t textSize(const displayItem *item) {
+  return ((item->kind >> 2) & 0x03) + 1;
+}
+
+static inline uint8_t textLength(const displayItem *item) {
+  return item->w / (6 * textSize(item));
+}
+
+static void removeItem(uint8_t i) {
+  displayItem *item = &items[i];
+
+  if ((item->kind & ITEM_TYPE) == ITEM_TEXT) {
+    uint8_t start = item->data;
+    uint8_t length = textLength(item);
+    memmove(&textPool[start], &textPool[start + length], textUsed - start - length);
+    textUsed -= length;
+    for (uint8_t j = 0; j < itemCount; j++)
+      if ((items[j].kind & ITEM_TYPE) == ITEM_TEXT && items[j].data > start)
+        items[j].data -= length;
+  }
+  itemCount--;
+  memmove(item, item + 1, (itemCount - i) * sizeof(displayItem));
+}
+
+// drop the items below count that lie completely inside a rectangle
+static void coverItems(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t count) {
+  for (uint8_t i = count; i--; ) {
+    displayItem *item = &items[i];
+    if (item->x >= x && item->x + item->w <= x + w &&
+        item->y >= y && item->y + item->h <= y + h)
+      removeItem(i);
+  }
+}
+
+static displayItem *newItem(uint8_t kind, uint8_t x, uint8_t y, uint8_t w, uint8_t h) {
+  displayItem *item;
+
+  if (itemCount == SH1106_LIST_ITEMS)
+    return NULL;
+  item = &items[itemCount++];
+  if (itemCount > itemPeak)
+    itemPeak = itemCount;
+  item->kind = kind;
+  item->x = x;
+  item->y = y;
+  item->w = w;
+  item->h = h;
+  item->data = 0;
+  return item;
+}
+
+static void listFill(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t color, int16_t width, int16_t height, bool flip) {
+  displayItem *last;
+
+  if (color > INVERSE || !clipRect(&x, &y, &w, &h, width, height))
+    return;
+  markRect(x, y, w, h, flip);
+
+  // lines are drawn a pixel or a line at a time, grow the last fill instead
+  last = itemCount ? &items[itemCount - 1] : NULL;
+  if (last && last->kind == (ITEM_FILL | color)) {
+    if (color != INVERSE && x >= last->x && x + w <= last->x + last->w &&
+        y >= last->y && y + h <= last->y + last->h)
+      return;
+    if (y == last->y && h == last->h && x == last->x + last->w) {
+      if (color != INVERSE)
+        coverItems(last->x, y, last->w + w, h, itemCount - 1);
+      items[itemCount - 1].w += w;
+      return;
+    }
+    if (x == last->x && w == last->w && y == last->y + last->h) {
+      if (color != INVERSE)
+        coverItems(x, last->y, w, last->h + h, itemCount - 1);
+      items[itemCount - 1].h += h;
+      return;
+    }
+  }
+  if (color != INVERSE)
+    coverItems(x, y, w, h, itemCount);
+  newItem(ITEM_FILL | color, x, y, w, h);
+}
+
+// Characters are only listed in the built in font, in text size 1 to 4 and
+// when they are within the screen, except for the rows below it. The
+// bottom row of the font is empty, so it is left out of the rectangle of
+// text without a background. A field that is cleared with a fill of the
+// height of its text then drops the old text.
+static void listChar(int16_t x, int16_t y, uint8_t c, uint16_t color, uint16_t bg, uint8_t size, int16_t width, int16_t height, bool flip) {
+  bool opaque = bg != color;
+  uint8_t w = 6 * size;
+  int16_t h = (opaque ? 8 : 7) * size;
+  displayItem *last, *item;
+  uint8_t kind;
+
+  if (size > 4 || color > WHITE || (opaque && bg > WHITE))
+    return;
+  if (x < 0 || y < 0 || x + w > width || y >= height)
+    return;
+  if (y + h > height)
+    h = height - y;
+  if (c < 0x20 || c > 0x7E)
+    c = ' ';
+  if (c == ' ' && !opaque)
+    return;
+
+  kind = ITEM_TEXT | (color == WHITE) | (opaque ? ITEM_OPAQUE : 0) | ((size - 1) << 2);
+  markRect(x, y, w, h, flip);
+
+  // A character right after the last one is added to its run. The whole
+  // run covers, or a field that is printed again would never drop the run
+  // it printed before.
+  last = itemCount ? &items[itemCount - 1] : NULL;
+  if (last && last->kind == kind && last->y == y && last->h == h && last->x + last->w == x &&
+      last->w + w <= 255 && last->data + textLength(last) == textUsed) {
+    if (opaque)
+      coverItems(last->x, y, last->w + w, h, itemCount - 1);
+    if (textUsed == SH1106_LIST_CHARS)
+      return;
+    items[itemCount - 1].w += w;
+  }
+  else {
+    if (opaque)
+      coverItems(x, y, w, h, itemCount);
+    if (textUsed == SH1106_LIST_CHARS)
+      return;
+    item = newItem(kind, x, y, w, h);
+    if (!item)
+      return;
+    item->data = textUsed;
+  }
+  textPool[textUsed++] = c;
+  if (textUsed > textPeak)
+    textPeak = textUsed;
+}
+
+// the bits of a column of a character run that fall in a page
+static uint8_t textBits(const displayItem *item, uint8_t x, uint8_t page) {
+  uint8_t size = textSize(item);
+  uint8_t offset = x - item->x;
+  uint8_t c = textPool[item->data + offset / (6 * size)];
+  uint8_t i = (offset % (6 * size)) / size;
+  uint8_t line = (i < 5) ? pgm_read_byte(&font[c * 5 + i]) : 0;
+  uint32_t bits = line;
+  int8_t shift = page * 8 - item->y;
+
+  if (size == 2) {
+    bits = pgm_read_byte(&fastSpread[line & 0x0F]) | (pgm_read_byte(&fastSpread[line >> 4]) << 8);
+  }
+  else if (size > 2) {
+    bits = 0;
+    for (i = 0; i < 8; i++)
+      if (line & (1 << i))
+        bits |= ((1UL << size) - 1) << (i * size);
+  }
+  return (shift >= 0) ? bits >> shift : bits << -shift;
+}
+
+// Render the dirty column range of a page from the display list. page and
+// the columns are the ones of the controller, the list is in the
+// coordinates of the current rotation.
+static void renderPage(uint8_t page, uint8_t lo, uint8_t hi, bool flip) {
+  uint8_t row = flip ? SH1106_PAGES - 1 - page : page;
+  uint8_t x0 = flip ? SH1106_LCDWIDTH - 1 - hi : lo;
+  uint8_t x1 = flip ? SH1106_LCDWIDTH - 1 - lo : hi;
+
+  memset(buffer + lo, 0, hi - lo + 1);
+  for (uint8_t i = 0; i < itemCount; i++) {
+    const displayItem *item = &items[i];
+    uint8_t mask = rowMask(item->y, item->h, row);
+    uint8_t a = item->x > x0 ? item->x : x0;
+    uint8_t b = item->x + item->w - 1 < x1 ? item->x + item->w - 1 : x1;
+    uint8_t color = item->kind & 0x03;
+
+    if (!mask || a > b)
+      continue;
+    for (uint8_t x = a; ; x++) {
+      switch (item->kind & ITEM_TYPE) {
+        case ITEM_FILL:
+          putBits(buffer, x, color == BLACK ? mask : 0, color == WHITE ? mask : 0,
+                  color == INVERSE ? mask : 0, flip);
+          break;
+        case ITEM_TEXT: {
+          uint8_t bits = textBits(item, x, row) & mask;
+          if (item->kind & ITEM_OPAQUE)
+            putBits(buffer, x, mask, (item->kind & WHITE) ? bits : mask & ~bits, 0, flip);
+          else
+            putBits(buffer, x, (item->kind & WHITE) ? 0 : bits, (item->kind & WHITE) ? bits : 0, 0, flip);
+          break;
+        }
+        case ITEM_LAYER:
+          putBits(buffer, x, mask, layers[item->data](x, row) & mask, 0, flip);
+          break;
+      }
+      if (x == b)
+        break;
+    }
+  }
+}
+
+void Adafruit_SH1106::drawPixel(int16_t x, int16_t y, uint16_t color) {
+  fillRect(x, y, 1, 1, color);
+}
+
+void Adafruit_SH1106::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+  fillRect(x, y, w, 1, color);
+}
+
+void Adafruit_SH1106::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+  fillRect(x, y, 1, h, color);
+}
+
+void Adafruit_SH1106::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  listFill(x, y, w, h, color, _width, _height, getRotation() == 2);
+}
+
+// empty the display list, the area it covered is sent as black
+void Adafruit_SH1106::clearDisplay(void) {
+  for (uint8_t i = 0; i < itemCount; i++)
+    markRect(items[i].x, items[i].y, items[i].w, items[i].h, getRotation() == 2);
+  itemCount = 0;
+  textUsed = 0;
+  memset(layers, 0, sizeof(layers));
+}
+
+// Add a layer, a rectangle whose bytes come from a function when a page is
+// rendered. Drawing a part of a layer that is already listed only marks that
+// part for the next display().
+void Adafruit_SH1106::drawLayer(int16_t x, int16_t y, int16_t w, int16_t h, SH1106_Layer layer) {
+  bool flip = getRotation() == 2;
+  displayItem *item;
+  uint8_t i, n;
+
+  if (!clipRect(&x, &y, &w, &h, _width, _height))
+    return;
+  markRect(x, y, w, h, flip);
+  for (n = 0; n < SH1106_LIST_LAYERS && layers[n] && layers[n] != layer; n++)
+    ;
+  if (n == SH1106_LIST_LAYERS)
+    return;
+  for (i = 0; layers[n] && i < itemCount; i++) {
+    item = &items[i];
+    if (item->kind == ITEM_LAYER && item->data == n && x >= item->x && x + w <= item->x + item->w &&
+        y >= item->y && y + h <= item->y + item->h)
+      return;
+  }
+  coverItems(x, y, w, h, itemCount);
+  item = newItem(ITEM_LAYER, x, y, w, h);
+  if (item) {
+    layers[n] = layer;
+    item->data = n;
+  }
+}
+
+// the most items and characters the display list has held
+void Adafruit_SH1106::listUsage(uint8_t *itemsUsed, uint8_t *charsUsed) {
+  *itemsUsed = itemPeak;
+  *charsUsed = textPeak;
+}
+
+size_t Adafruit_SH1106::write(uint8_t c) {
+  if (c == '\n') {
+    cursor_y += textsize * 8;
+    cursor_x = 0;
+  }
+  else if (c != '\r') {
+    if (wrap && cursor_x + textsize * 6 > _width) {
+      cursor_x = 0;
+      cursor_y += textsize * 8;
+    }
+    listChar(cursor_x, cursor_y, c, textcolor, textbgcolor, textsize, _width, _height, getRotation() == 2);
+    cursor_x += textsize * 6;
+  }
+  return 1;
+}
+#endif
 
 #define sh1106_swap(a, b) { int16_t t = a; a = b; b = t; }
 
+#ifndef SH1106_PAGE_BUFFER
 // the most basic function, set a single pixel
 void Adafruit_SH1106::drawPixel(int16_t x, int16_t y, uint16_t color) {
   if ((x < 0) || (x >= width()) || (y < 0) || (y >= height()))
@@ -133,6 +691,8 @@ void Adafruit_SH1106::drawPixel(int16_t x, int16_t y, uint16_t color) {
     break;
   }  
 
+  markDirty(y / 8, x, x);
+
   // x is which column
     switch (color) 
     {
@@ -142,6 +702,7 @@ void Adafruit_SH1106::drawPixel(int16_t x, int16_t y, uint16_t color) {
     }
     
 }
+#endif
 
 Adafruit_SH1106::Adafruit_SH1106(int8_t SID, int8_t SCLK, int8_t DC, int8_t RST, int8_t CS) : Adafruit_GFX(SH1106_LCDWIDTH, SH1106_LCDHEIGHT) {
   cs = CS;
@@ -172,6 +733,9 @@ void Adafruit_SH1106::begin(uint8_t vccstate, uint8_t i2caddr, bool reset) {
   _vccstate = vccstate;
   _i2caddr = i2caddr;
 
+  // the controller RAM content is unknown, send everything on the first display()
+  markAllDirty();
+
   // set pin directions
   if (sid != -1){
     pinMode(dc, OUTPUT);
@@ -201,7 +765,16 @@ void Adafruit_SH1106::begin(uint8_t vccstate, uint8_t i2caddr, bool reset) {
   else
   {
     // I2C Init
+#ifdef SH1106_TWI_ASYNC
+    twiAddr = i2caddr;
+    pinMode(SDA, INPUT_PULLUP);
+    pinMode(SCL, INPUT_PULLUP);
+    TWSR = 0;                                 // prescaler 1
+    TWBR = ((F_CPU / 400000L) - 16) / 2;      // 400 KHz, or as close as the clock allows
+    TWCR = _BV(TWEN);
+#else
     Wire.begin();
+#endif
 #ifdef __SAM3X8E__
     // Force 400 KHz I2C, rawr! (Uses pins 20, 21 for SDA, SCL)
     TWI1->TWI_CWGR = 0;
@@ -362,11 +935,23 @@ void Adafruit_SH1106::SH1106_command(uint8_t c) {
   else
   {
     // I2C
+#ifdef SH1106_TWI_ASYNC
+    static uint8_t cmd;
+    waitFlush();
+    cmd = c;
+    twiState = TWI_COMMAND;
+    twiControl = 0x00;        // Co = 0, D/C = 0
+    twiPtr = &cmd;
+    twiLen = 1;
+    twiStart();
+    waitFlush();
+#else
     uint8_t control = 0x00;   // Co = 0, D/C = 0
     Wire.beginTransmission(_i2caddr);
     WIRE_WRITE(control);
     WIRE_WRITE(c);
     Wire.endTransmission();
+#endif
   }
  
 }
@@ -437,7 +1022,7 @@ void Adafruit_SH1106::startscrolldiagleft(uint8_t start, uint8_t stop){
 
 void Adafruit_SH1106::stopscroll(void){
   SH1106_command(SH1106_DEACTIVATE_SCROLL);
-}
+}*/
 
 // Dim the display
 // dim = true: display is dimmed
@@ -458,7 +1043,7 @@ void Adafruit_SH1106::dim(boolean dim) {
   // it is useful to dim the display
   SH1106_command(SH1106_SETCONTRAST);
   SH1106_command(contrast);
-}*/
+}
 
 void Adafruit_SH1106::SH1106_data(uint8_t c) {
  
@@ -478,11 +1063,23 @@ void Adafruit_SH1106::SH1106_data(uint8_t c) {
   else
   {
     // I2C
+#ifdef SH1106_TWI_ASYNC
+    static uint8_t data;
+    waitFlush();
+    data = c;
+    twiState = TWI_COMMAND;
+    twiControl = 0x40;        // Co = 0, D/C = 1
+    twiPtr = &data;
+    twiLen = 1;
+    twiStart();
+    waitFlush();
+#else
     uint8_t control = 0x40;   // Co = 0, D/C = 1
     Wire.beginTransmission(_i2caddr);
     WIRE_WRITE(control);
     WIRE_WRITE(c);
     Wire.endTransmission();
+#endif
   }
   
 }
@@ -492,87 +1089,120 @@ void Adafruit_SH1106::SH1106_data(uint8_t c) {
 #define SH1106_SETSTARTLINE 0x40*/
 
 void Adafruit_SH1106::display(void) {
-	
-    SH1106_command(SH1106_SETLOWCOLUMN | 0x0);  // low col = 0
-    SH1106_command(SH1106_SETHIGHCOLUMN | 0x0);  // hi col = 0
-    SH1106_command(SH1106_SETSTARTLINE | 0x0); // line #0
-	
-  
+  // Only the dirty column range of each page is sent. Pages that have not been
+  // touched since the last call are skipped entirely.
+  byte m_col = 0;       // column offset in the 132 column controller RAM
+  byte i, k;
+  uint8_t *p;
 
+  if (sid != -1)
+  {
+    for (i = 0; i < SH1106_PAGES; i++) {
+      if (dirtyLo[i] > dirtyHi[i])
+        continue;
 
-    //Serial.println(TWBR, DEC);
-    //Serial.println(TWSR & 0x3, DEC);
+      SH1106_command(0xB0 + i);                                   //set page address
+      SH1106_command((dirtyLo[i] + m_col) & 0xf);                 //set lower column address
+      SH1106_command(0x10 | ((dirtyLo[i] + m_col) >> 4));        //set higher column address
 
-    // I2C
-    //height >>= 3;
-    //width >>= 3;
-	byte height=64;
-	byte width=128;
-	byte m_row = 0;
-	byte m_col = 0;
-	
-	
-	height >>= 3;
-	width >>= 3;
-	//Serial.println(width);
-	
-	int p = 0;
-	
-	byte i, j, k =0;
-	
-	if(sid != -1)
-	{
-			
-		for ( i = 0; i < height; i++) {
-		
-		// send a bunch of data in one xmission
-        SH1106_command(0xB0 + i + m_row);//set page address
-        SH1106_command(m_col & 0xf);//set lower column address
-        SH1106_command(0x10 | (m_col >> 4));//set higher column address
-		
-        for( j = 0; j < 8; j++){        
-			// SPI
-			*csport |= cspinmask;
-			*dcport |= dcpinmask;
-			*csport &= ~cspinmask;
-			
-            for ( k = 0; k < width; k++, p++) {
-					fastSPIwrite(buffer[p]);
-            }
-            *csport |= cspinmask;
-        }
-		}
-		
-	}
-	else{
-		
-	 // save I2C bitrate
-	#ifndef __SAM3X8E__
-    		uint8_t twbrbackup = TWBR;
-    		TWBR = 12; // upgrade to 400KHz!
-	#endif
-	
-	for ( i = 0; i < height; i++) {
-		
-		// send a bunch of data in one xmission
-        SH1106_command(0xB0 + i + m_row);//set page address
-        SH1106_command(m_col & 0xf);//set lower column address
-        SH1106_command(0x10 | (m_col >> 4));//set higher column address
-		
-        for( j = 0; j < 8; j++){        
-			Wire.beginTransmission(_i2caddr);
-            Wire.write(0x40);
-            for ( k = 0; k < width; k++, p++) {
-		Wire.write(buffer[p]);
-            }
-            Wire.endTransmission();
-        	}
-	}
-	
-	#ifndef __SAM3X8E__
-    		TWBR = twbrbackup;
-	#endif
-	}
+#ifdef SH1106_PAGE_BUFFER
+      renderPage(i, dirtyLo[i], dirtyHi[i], getRotation() == 2);
+#endif
+      // SPI
+      *csport |= cspinmask;
+      *dcport |= dcpinmask;
+      *csport &= ~cspinmask;
+      p = pageData(i, dirtyLo[i]);
+      for (k = dirtyLo[i]; k <= dirtyHi[i]; k++)
+        fastSPIwrite(*p++);
+      *csport |= cspinmask;
+
+      dirtyLo[i] = 0xFF;
+      dirtyHi[i] = 0;
+    }
+  }
+  else
+  {
+#if defined SH1106_TWI_ASYNC && defined SH1106_PAGE_BUFFER
+    // There is a single page buffer, so every page is sent before the next
+    // one is rendered
+    for (i = 0; i < SH1106_PAGES; i++) {
+      if (dirtyLo[i] > dirtyHi[i])
+        continue;
+      waitFlush();
+      renderPage(i, dirtyLo[i], dirtyHi[i], getRotation() == 2);
+      twiPageEnd = i + 1;
+      twiNextPage(i);
+      twiStart();
+    }
+    waitFlush();
+#elif defined SH1106_TWI_ASYNC
+    // Start the background transfer, or ask a running one to make another
+    // pass over the pages when it is done.
+    uint8_t sreg = SREG;
+    cli();
+    if (twiState != TWI_IDLE) {
+      twiAgain = 1;
+      SREG = sreg;
+      return;
+    }
+    SREG = sreg;
+    if (twiNextPage(0))
+      twiStart();
+#else
+    uint8_t n;
+
+    // save I2C bitrate
+#ifndef __SAM3X8E__
+    uint8_t twbrbackup = TWBR;
+    TWBR = 12; // upgrade to 400KHz!
+#endif
+
+    for (i = 0; i < SH1106_PAGES; i++) {
+      if (dirtyLo[i] > dirtyHi[i])
+        continue;
+
+      SH1106_command(0xB0 + i);                                   //set page address
+      SH1106_command((dirtyLo[i] + m_col) & 0xf);                 //set lower column address
+      SH1106_command(0x10 | ((dirtyLo[i] + m_col) >> 4));        //set higher column address
+
+#ifdef SH1106_PAGE_BUFFER
+      renderPage(i, dirtyLo[i], dirtyHi[i], getRotation() == 2);
+#endif
+      // send a bunch of data in one xmission, the Wire buffer holds 32 bytes
+      p = pageData(i, dirtyLo[i]);
+      n = dirtyHi[i] - dirtyLo[i] + 1;
+      while (n) {
+        Wire.beginTransmission(_i2caddr);
+        WIRE_WRITE(0x40);
+        for (k = 0; k < 16 && n; k++, n--)
+          WIRE_WRITE(*p++);
+        Wire.endTransmission();
+      }
+
+      dirtyLo[i] = 0xFF;
+      dirtyHi[i] = 0;
+    }
+
+#ifndef __SAM3X8E__
+    TWBR = twbrbackup;
+#endif
+#endif
+  }
+}
+
+// true when no background transfer is running
+bool Adafruit_SH1106::flushComplete(void) {
+#ifdef SH1106_TWI_ASYNC
+  return twiState == TWI_IDLE;
+#else
+  return true;
+#endif
+}
+
+void Adafruit_SH1106::waitFlush(void) {
+  while (!flushComplete())
+    ;
 }
 
 /*void Adafruit_SH1106::display(void) {
@@ -640,10 +1270,27 @@ void Adafruit_SH1106::display(void) {
   }
 }
 */
-// clear everything
+#ifndef SH1106_PAGE_BUFFER
+// clear everything, only the columns that held set pixels are marked dirty
 void Adafruit_SH1106::clearDisplay(void) {
-  memset(buffer, 0, (SH1106_LCDWIDTH*SH1106_LCDHEIGHT/8));
+  uint8_t *p = buffer;
+  uint8_t i, x, lo, hi;
+
+  for (i = 0; i < SH1106_PAGES; i++) {
+    lo = 0xFF;
+    hi = 0;
+    for (x = 0; x < SH1106_LCDWIDTH; x++, p++) {
+      if (*p) {
+        if (lo == 0xFF) lo = x;
+        hi = x;
+        *p = 0;
+      }
+    }
+    if (lo != 0xFF)
+      markDirty(i, lo, hi);
+  }
 }
+#endif
 
 
 inline void Adafruit_SH1106::fastSPIwrite(uint8_t d) {
@@ -661,6 +1308,7 @@ inline void Adafruit_SH1106::fastSPIwrite(uint8_t d) {
   //*csport |= cspinmask;
 }
 
+#ifndef SH1106_PAGE_BUFFER
 void Adafruit_SH1106::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
   boolean bSwap = false;
   switch(rotation) { 
@@ -713,6 +1361,8 @@ void Adafruit_SH1106::drawFastHLineInternal(int16_t x, int16_t y, int16_t w, uin
   // if our width is now negative, punt
   if(w <= 0) { return; }
 
+  markDirty(y / 8, x, x + w - 1);
+
   // set up the pointer for  movement through the buffer
   register uint8_t *pBuf = buffer;
   // adjust the buffer pointer for the current row
@@ -791,6 +1441,9 @@ void Adafruit_SH1106::drawFastVLineInternal(int16_t x, int16_t __y, int16_t __h,
   register uint8_t y = __y;
   register uint8_t h = __h;
 
+  for (uint8_t page = y / 8; page <= (y + h - 1) / 8; page++)
+    markDirty(page, x, x);
+
 
   // set up the pointer for fast movement through the buffer
   register uint8_t *pBuf = buffer;
@@ -877,3 +1530,104 @@ void Adafruit_SH1106::drawFastVLineInternal(int16_t x, int16_t __y, int16_t __h,
     }
   }
 }
+
+// Add a layer, a rectangle whose bytes come from a function. The function
+// is called at once for every page and column of the rectangle.
+void Adafruit_SH1106::drawLayer(int16_t x, int16_t y, int16_t w, int16_t h, SH1106_Layer layer) {
+  bool flip = getRotation() == 2;
+  uint8_t page, column, mask;
+
+  if ((getRotation() & 1) || !clipRect(&x, &y, &w, &h, _width, _height))
+    return;
+  markRect(x, y, w, h, flip);
+  for (page = y / 8; page <= (y + h - 1) / 8; page++) {
+    uint8_t *data = buffer + (flip ? SH1106_PAGES - 1 - page : page) * SH1106_LCDWIDTH;
+    mask = rowMask(y, h, page);
+    for (column = x; column < x + w; column++)
+      putBits(data, column, mask, layer(column, page) & mask, 0, flip);
+  }
+}
+
+#ifdef SH1106_FAST_TEXT
+// switch the page aligned text path on or off, to compare it with GFX
+void Adafruit_SH1106::setFastText(bool enable) {
+  fastTextEnabled = enable;
+}
+
+// store one glyph byte at a column and page given in text coordinates
+void Adafruit_SH1106::fastTextByte(uint8_t x, uint8_t page, uint8_t bits) {
+  if (getRotation() == 2) {
+    x = SH1106_LCDWIDTH - 1 - x;
+    page = SH1106_PAGES - 1 - page;
+    bits = reverseBits(bits);
+  }
+  uint8_t *pBuf = &buffer[x + page * SH1106_LCDWIDTH];
+  if (textbgcolor != textcolor)
+    *pBuf = (textcolor == WHITE) ? bits : ~bits;
+  else if (textcolor == WHITE)
+    *pBuf |= bits;
+  else
+    *pBuf &= ~bits;
+}
+
+// Draw a character straight into the framebuffer, one byte for every
+// 8 rows of a glyph column. Only text on a page boundary in size 1 or 2,
+// or digits in size 3, takes this path. Anything else, including a
+// character that might wrap, returns false and is left to GFX.
+bool Adafruit_SH1106::fastTextChar(uint8_t c) {
+  uint8_t size = textsize;
+  int16_t w = 6 * size;
+
+  if (c < 0x20 || c > 0x7E || (getRotation() & 1) || (cursor_y & 7))
+    return false;
+  if (size > 3 || (size == 3 && (c < '0' || c > '9')))
+    return false;
+  if (textcolor > WHITE || textbgcolor > WHITE)
+    return false;
+  // GFX versions differ in whether they wrap before or after a character,
+  // keep clear of both
+  if (cursor_x < 0 || cursor_x + (wrap ? 2 * w : w) > _width || cursor_y + 8 * size > _height)
+    return false;
+
+  uint8_t x = cursor_x;
+  uint8_t page = cursor_y / 8;
+  const uint8_t *glyph = font + c * 5;
+
+  for (uint8_t i = 0; i < 6; i++) {
+    uint8_t line = (i < 5) ? pgm_read_byte(&glyph[i]) : 0;
+    for (uint8_t r = 0; r < size; r++, x++) {
+      if (size == 1) {
+        fastTextByte(x, page, line);
+      } else if (size == 2) {
+        fastTextByte(x, page, pgm_read_byte(&fastSpread[line & 0x0F]));
+        fastTextByte(x, page + 1, pgm_read_byte(&fastSpread[line >> 4]));
+      } else {
+        for (uint8_t p = 0; p < 3; p++)
+          fastTextByte(x, page + p, (i < 5) ? pgm_read_byte(&fastDigits3[c - '0'][i][p]) : 0);
+      }
+    }
+  }
+
+  uint8_t x0 = cursor_x;
+  uint8_t x1 = cursor_x + w - 1;
+  if (getRotation() == 2) {
+    x0 = SH1106_LCDWIDTH - 1 - x1;
+    x1 = SH1106_LCDWIDTH - 1 - cursor_x;
+    page = SH1106_PAGES - page - size;
+  }
+  for (uint8_t p = page; p < page + size; p++)
+    markDirty(p, x0, x1);
+
+  cursor_x += w;
+  return true;
+}
+#endif
+
+size_t Adafruit_SH1106::write(uint8_t c) {
+#ifdef SH1106_FAST_TEXT
+  if (fastTextEnabled && fastTextChar(c))
+    return 1;
+#endif
+  return Adafruit_GFX::write(c);
+}
+#endif
@@ -92,6 +92,67 @@ However, SH1106 driver don't provide several functions such as scroll commands.
   #define SH1106_LCDHEIGHT                 16
 #endif
 
+/*=========================================================================
+    Asynchronous I2C flush
+    -----------------------------------------------------------------------
+    When enabled, display() only starts the transfer of the dirty pages and
+    returns at once. The framebuffer is streamed in the background from the
+    TWI interrupt. Use flushComplete() to poll or waitFlush() to block until
+    the transfer is done. Drawing while a flush runs is allowed, pages that
+    change are sent again on the next display().
+
+    The Wire library is not used in this mode, since it owns the TWI
+    interrupt. Only AVR targets are supported, others use Wire as before.
+    -----------------------------------------------------------------------*/
+   #define SH1106_ASYNC_FLUSH
+/*=========================================================================*/
+
+#if defined SH1106_ASYNC_FLUSH && defined __AVR__
+  #define SH1106_TWI_ASYNC
+#endif
+
+// Wire links its own TWI interrupt, which clashes with the one of this driver
+#if defined SH1106_TWI_ASYNC && defined TwoWire_h
+  #error "Wire.h can not be used together with SH1106_ASYNC_FLUSH"
+#endif
+
+/*=========================================================================
+    Page aligned text
+    -----------------------------------------------------------------------
+    When enabled, write() draws text whose top is on a page boundary
+    (y a multiple of 8) by storing whole glyph column bytes in the
+    framebuffer instead of going through drawPixel() and fillRect().
+    Sizes 1 and 2 are supported for all printable characters, size 3 for
+    the digits, which come pre-rendered from flash. All other text is
+    drawn by GFX as before, the result is the same pixel for pixel.
+    -----------------------------------------------------------------------*/
+   #define SH1106_FAST_TEXT
+/*=========================================================================*/
+
+/*=========================================================================
+    Page buffer
+    -----------------------------------------------------------------------
+    When enabled, the 1 KB framebuffer is replaced by a display list and a
+    buffer for a single page. Drawing adds fills, runs of characters and
+    layers to the list, and display() renders every dirty page from the
+    list just before it is sent. An item that a later opaque one covers
+    completely is dropped, so the list holds what is visible. display()
+    waits until the transfer is done in this mode.
+
+    Only rotation 0 and 2 and whole characters of the built in font are
+    supported. Drawing that does not fit in the list is lost, listUsage()
+    gives the peak use to size it.
+    -----------------------------------------------------------------------*/
+//   #define SH1106_PAGE_BUFFER
+   #define SH1106_LIST_ITEMS    40    // 6 bytes each
+   #define SH1106_LIST_CHARS    192
+   #define SH1106_LIST_LAYERS   2
+/*=========================================================================*/
+
+#ifdef SH1106_PAGE_BUFFER
+  #undef SH1106_FAST_TEXT
+#endif
+
 #define SH1106_SETCONTRAST 0x81
 #define SH1106_DISPLAYALLON_RESUME 0xA4
 #define SH1106_DISPLAYALLON 0xA5
@@ -138,6 +199,9 @@ However, SH1106 driver don't provide several functions such as scroll commands.
 #define SH1106_VERTICAL_AND_RIGHT_HORIZONTAL_SCROLL 0x29
 #define SH1106_VERTICAL_AND_LEFT_HORIZONTAL_SCROLL 0x2A
 
+// returns the byte of a layer for a column and a page, LSB on top
+typedef uint8_t (*SH1106_Layer)(uint8_t x, uint8_t page);
+
 class Adafruit_SH1106 : public Adafruit_GFX {
  public:
   Adafruit_SH1106(int8_t SID, int8_t SCLK, int8_t DC, int8_t RST, int8_t CS);
@@ -151,6 +215,8 @@ class Adafruit_SH1106 : public Adafruit_GFX {
   void clearDisplay(void);
   void invertDisplay(uint8_t i);
   void display();
+  bool flushComplete(void);
+  void waitFlush(void);
 
   /*void startscrollright(uint8_t start, uint8_t stop);
   void startscrollleft(uint8_t start, uint8_t stop);
@@ -159,13 +225,23 @@ class Adafruit_SH1106 : public Adafruit_GFX {
   void startscrolldiagleft(uint8_t start, uint8_t stop);
   void stopscroll(void); */
   
-  void dim(uint8_t contrast);
+  void dim(boolean dim);
 
   void drawPixel(int16_t x, int16_t y, uint16_t color);
 
   virtual void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
   virtual void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
 
+  virtual size_t write(uint8_t c);
+#ifdef SH1106_FAST_TEXT
+  void setFastText(bool enable);
+#endif
+  void drawLayer(int16_t x, int16_t y, int16_t w, int16_t h, SH1106_Layer layer);
+#ifdef SH1106_PAGE_BUFFER
+  virtual void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  void listUsage(uint8_t *items, uint8_t *chars);
+#endif
+
  private:
   int8_t _i2caddr, _vccstate, sid, sclk, dc, rst, cs;
   void fastSPIwrite(uint8_t c);
@@ -174,7 +250,13 @@ class Adafruit_SH1106 : public Adafruit_GFX {
   PortReg *mosiport, *clkport, *csport, *dcport;
   PortMask mosipinmask, clkpinmask, cspinmask, dcpinmask;
 
+#ifndef SH1106_PAGE_BUFFER
   inline void drawFastVLineInternal(int16_t x, int16_t y, int16_t h, uint16_t color) __attribute__((always_inline));
   inline void drawFastHLineInternal(int16_t x, int16_t y, int16_t w, uint16_t color) __attribute__((always_inline));
+#endif
+#ifdef SH1106_FAST_TEXT
+  bool fastTextChar(uint8_t c);
+  void fastTextByte(uint8_t x, uint8_t page, uint8_t bits);
+#endif
 
 };
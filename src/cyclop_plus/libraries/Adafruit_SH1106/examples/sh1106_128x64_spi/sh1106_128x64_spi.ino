@@ -17,7 +17,6 @@ All text above, and the splash screen must be included in any redistribution
 *********************************************************************/
 
 #include <SPI.h>
-#include <Wire.h>
 #include <Adafruit_GFX.h>
 #include <Adafruit_SH1106.h>
 
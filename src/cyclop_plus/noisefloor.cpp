@@ -0,0 +1,217 @@
+/*******************************************************************************
+  This is the noise floor estimator. The graphic scanner hands it every
+  complete sweep of the band, and the auto scanner every search that found
+  nothing. The floor is a low rank of the sweep, so transmitters do not lift
+  it, and the ceiling follows the strongest column. Both are averaged over the
+  sweeps and saved with the settings.
+
+  The MIT License (MIT)
+
+  Copyright (c) 2017 Kjell Kernen (Dvogonen)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+********************************************************************************/
+// Application includes
+#include "Arduino.h"
+#include "noisefloor.h"
+#include "spectrum.h"
+
+//******************************************************************************
+//* File scope variables
+
+static uint16_t floorLevel = NOISE_FLOOR_DEFAULT;
+static uint16_t ceilingLevel = NOISE_CEILING_DEFAULT;
+static uint16_t enterLevel = 0;
+static uint16_t leaveLevel = 0;
+static uint16_t levelScale = 0;          // NOISE_LEVEL_CEILING / span, in 1/256
+static bool     learned = false;
+static uint8_t  savedFloor = 0;
+static uint8_t  savedCeiling = 0;
+
+//******************************************************************************
+//* function: noiseUpdate
+//*         : derives the levels and the scale from the floor and the ceiling
+//******************************************************************************
+static void noiseUpdate( void )
+{
+  uint16_t span, enter, leave;
+
+  if (floorLevel > 1020 - NOISE_MIN_SPAN)
+    floorLevel = 1020 - NOISE_MIN_SPAN;
+  if (ceilingLevel < floorLevel + NOISE_MIN_SPAN)
+    ceilingLevel = floorLevel + NOISE_MIN_SPAN;
+  if (ceilingLevel > 1020)
+    ceilingLevel = 1020;
+  span = ceilingLevel - floorLevel;
+  enter = span * NOISE_ENTER_PART / 16;
+  leave = span * NOISE_LEAVE_PART / 16;
+  enterLevel = floorLevel + (enter > NOISE_ENTER_MARGIN ? enter : NOISE_ENTER_MARGIN);
+  leaveLevel = floorLevel + (leave > NOISE_LEAVE_MARGIN ? leave : NOISE_LEAVE_MARGIN);
+  levelScale = ((uint16_t)NOISE_LEVEL_CEILING << 8) / span;
+}
+
+//******************************************************************************
+//* function: noiseBegin
+//*         : starts from saved levels, or from the defaults if they are 0
+//******************************************************************************
+void noiseBegin( const uint8_t *levels )
+{
+  learned = levels[0] && levels[1];
+  if (learned) {
+    floorLevel = (uint16_t)levels[0] << 2;
+    ceilingLevel = (uint16_t)levels[1] << 2;
+  }
+  else {
+    floorLevel = NOISE_FLOOR_DEFAULT;
+    ceilingLevel = NOISE_CEILING_DEFAULT;
+  }
+  savedFloor = levels[0];
+  savedCeiling = levels[1];
+  noiseUpdate();
+}
+
+//******************************************************************************
+//* function: noiseLearn
+//*         : averages the floor and the ceiling of the stored spectrum into
+//*         : the levels. Needs at least half of the columns to be known.
+//******************************************************************************
+void noiseLearn( void )
+{
+  uint8_t  column, value, rank, below;
+  uint8_t  known = 0, top = 0;
+  uint8_t  low, high, middle;
+  uint16_t floorSample, topSample;
+
+  for (column = 0; column < SPECTRUM_COLUMNS; column++) {
+    value = spectrumCurrent(column);
+    if (!value)
+      continue;
+    known++;
+    if (value > top)
+      top = value;
+  }
+  if (known < SPECTRUM_COLUMNS / 2)
+    return;
+
+  // Bisect for the lowest value that rank of the columns reach, it takes a
+  // few passes over the store but no buffer for sorting
+  rank = known >> NOISE_FLOOR_RANK_SHIFT;
+  low = 1;
+  high = top;
+  while (low < high) {
+    middle = low + (high - low) / 2;
+    below = 0;
+    for (column = 0; column < SPECTRUM_COLUMNS; column++) {
+      value = spectrumCurrent(column);
+      if (value && value <= middle)
+        below++;
+    }
+    if (below >= rank)
+      high = middle;
+    else
+      low = middle + 1;
+  }
+  floorSample = (uint16_t)low << 2;
+  topSample = (uint16_t)top << 2;
+
+  if (!learned) {
+    floorLevel = floorSample;
+    ceilingLevel = topSample;
+    learned = true;
+  }
+  else {
+    floorLevel += ((int16_t)floorSample - (int16_t)floorLevel) >> NOISE_FLOOR_SHIFT;
+    if (topSample > ceilingLevel)
+      ceilingLevel += (topSample - ceilingLevel) >> NOISE_RISE_SHIFT;
+    else
+      ceilingLevel -= (ceilingLevel - topSample) >> NOISE_FALL_SHIFT;
+  }
+  noiseUpdate();
+}
+
+//******************************************************************************
+//* function: noiseUnsaved
+//*         : true if the learned levels have moved away from the saved ones
+//******************************************************************************
+bool noiseUnsaved( void )
+{
+  if (!learned)
+    return false;
+  return abs((int16_t)(floorLevel >> 2) - savedFloor) >= NOISE_SAVE_DELTA ||
+         abs((int16_t)(ceilingLevel >> 2) - savedCeiling) >= NOISE_SAVE_DELTA;
+}
+
+//******************************************************************************
+//* function: noiseSave
+//*         : returns the levels to save and takes them as the saved ones
+//******************************************************************************
+void noiseSave( uint8_t *levels )
+{
+  if (learned) {
+    savedFloor = floorLevel >> 2;
+    savedCeiling = ceilingLevel >> 2;
+    if (!savedFloor)
+      savedFloor = 1;
+  }
+  levels[0] = savedFloor;
+  levels[1] = savedCeiling;
+}
+
+uint16_t noiseFloor( void )
+{
+  return floorLevel;
+}
+
+uint16_t noiseCeiling( void )
+{
+  return ceilingLevel;
+}
+
+//******************************************************************************
+//* function: noiseEnter
+//*         : the RSSI a signal has to reach to be found
+//******************************************************************************
+uint16_t noiseEnter( void )
+{
+  return enterLevel;
+}
+
+//******************************************************************************
+//* function: noiseLeave
+//*         : the RSSI a signal has to drop below before the next is found
+//******************************************************************************
+uint16_t noiseLeave( void )
+{
+  return leaveLevel;
+}
+
+//******************************************************************************
+//* function: noiseLevel
+//*         : returns the RSSI relative to the learned span, 0 at the floor and
+//*         : NOISE_LEVEL_CEILING at the ceiling, at most 255
+//******************************************************************************
+uint8_t noiseLevel( uint16_t rssi )
+{
+  uint32_t level;
+
+  if (rssi <= floorLevel)
+    return 0;
+  level = ((uint32_t)(rssi - floorLevel) * levelScale) >> 8;
+  return level > 255 ? 255 : level;
+}
@@ -0,0 +1,80 @@
+/*******************************************************************************
+  This is the header file for the noise floor estimator. It learns the RSSI of
+  an empty channel and of a strong transmitter on this receiver from complete
+  sweeps of the band, and derives the levels the auto scanner stops at and the
+  scale of the scanner bars from them. Receivers differ a lot in both, so fixed
+  levels stop too early on noisy modules and never on weak ones.
+
+  The MIT License (MIT)
+
+  Copyright (c) 2017 Kjell Kernen (Dvogonen)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+********************************************************************************/
+#ifndef noisefloor_h
+#define noisefloor_h
+
+#include "Arduino.h"
+
+// Levels of a receiver that has not learned its own yet, in RSSI counts.
+// They put the enter level at 252, close to the fixed 250 used before.
+#define NOISE_FLOOR_DEFAULT     140
+#define NOISE_CEILING_DEFAULT   440
+
+// Smallest distance from the floor to the ceiling, keeps the noise of an
+// empty band from filling the scanner bars
+#define NOISE_MIN_SPAN          160
+
+// A signal is found at 6/16 of the span above the floor and lost again at
+// 3/16, but never closer to the floor than the margins
+#define NOISE_ENTER_PART        6
+#define NOISE_ENTER_MARGIN      40
+#define NOISE_LEAVE_PART        3
+#define NOISE_LEAVE_MARGIN      20
+
+// Weight of a sweep in the floor (1/4), and in a ceiling that rises (1/2)
+// or falls (1/8)
+#define NOISE_FLOOR_SHIFT       2
+#define NOISE_RISE_SHIFT        1
+#define NOISE_FALL_SHIFT        3
+
+// The floor is the value the lowest quarter (1/4) of the columns of a sweep
+// stay at or below
+#define NOISE_FLOOR_RANK_SHIFT  2
+
+// Saved levels are RSSI / 4 in two bytes, 0 when nothing has been learned.
+// New levels are saved once they move this far from the saved ones.
+#define NOISE_LEVELS            2
+#define NOISE_SAVE_DELTA        2
+
+// Relative level of the ceiling, see noiseLevel()
+#define NOISE_LEVEL_CEILING     64
+
+void     noiseBegin( const uint8_t *levels );
+void     noiseLearn( void );
+bool     noiseUnsaved( void );
+void     noiseSave( uint8_t *levels );
+
+uint16_t noiseFloor( void );
+uint16_t noiseCeiling( void );
+uint16_t noiseEnter( void );
+uint16_t noiseLeave( void );
+uint8_t  noiseLevel( uint16_t rssi );
+
+#endif // noisefloor_h
@@ -0,0 +1,199 @@
+/*******************************************************************************
+  This file contains the phase profiler, see profiler.h. Phases may begin in
+  one function and end in another, and the interrupt phases may end while a
+  main loop phase is running.
+
+  The MIT License (MIT)
+
+  Copyright (c) 2017 Kjell Kernen (Dvogonen)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+********************************************************************************/
+// Application includes
+#include "Arduino.h"
+#include "profiler.h"
+
+#ifdef PROFILE_PHASES
+
+// Library includes
+#ifdef __AVR__
+#include <util/atomic.h>
+#endif
+
+//******************************************************************************
+//* File scope variables
+
+struct profileSample {
+  uint8_t  phase;
+  uint16_t time;
+};
+
+static uint32_t      profileStart[PROFILE_COUNT];
+static uint16_t      profileLow[PROFILE_COUNT];
+static uint16_t      profileHigh[PROFILE_COUNT];
+static uint32_t      profileSum[PROFILE_COUNT];
+static uint16_t      profileSamples[PROFILE_COUNT];
+static profileSample profileRing[PROFILE_RING_SIZE];
+static uint8_t       profileHead = 0;
+static uint8_t       profileFill = 0;
+
+static const char profileNames[PROFILE_COUNT][7] PROGMEM = {
+  "Tune", "Settle", "AdcIsr", "BtnIsr", "Flush", "Eeprom", "Loop",
+  "Chan", "Scan", "ScanUp", "Auto", "Func", "Option", "Start", "Hop",
+  "Fall"
+};
+
+//******************************************************************************
+//* function: profileBegin
+//******************************************************************************
+void profileBegin( uint8_t phase )
+{
+  profileStart[phase] = micros();
+}
+
+//******************************************************************************
+//* function: profileEnd
+//*         : records the time since profileBegin, saturated to 65535 us
+//******************************************************************************
+void profileEnd( uint8_t phase )
+{
+  uint32_t elapsed = micros() - profileStart[phase];
+  uint16_t time = elapsed > 0xFFFF ? 0xFFFF : elapsed;
+
+#ifdef __AVR__
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+#endif
+  {
+    profileRing[profileHead].phase = phase;
+    profileRing[profileHead].time = time;
+    profileHead = (profileHead + 1) % PROFILE_RING_SIZE;
+    if (profileFill < PROFILE_RING_SIZE)
+      profileFill++;
+
+    if (!profileSamples[phase] || time < profileLow[phase])
+      profileLow[phase] = time;
+    if (time > profileHigh[phase])
+      profileHigh[phase] = time;
+    if (profileSamples[phase] < 0xFFFF) {
+      profileSum[phase] += time;
+      profileSamples[phase]++;
+    }
+  }
+}
+
+//******************************************************************************
+//* function: profileReset
+//*         : clears the statistics and the ring buffer
+//******************************************************************************
+void profileReset( void )
+{
+#ifdef __AVR__
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+#endif
+  {
+    memset(profileLow, 0, sizeof(profileLow));
+    memset(profileHigh, 0, sizeof(profileHigh));
+    memset(profileSum, 0, sizeof(profileSum));
+    memset(profileSamples, 0, sizeof(profileSamples));
+    profileHead = 0;
+    profileFill = 0;
+  }
+}
+
+//******************************************************************************
+//* function: profileMin, profileMean, profileMax, profileCount
+//*         : statistics of a phase in microseconds
+//******************************************************************************
+uint16_t profileMin( uint8_t phase )
+{
+  return profileLow[phase];
+}
+
+uint16_t profileMean( uint8_t phase )
+{
+  uint32_t sum;
+  uint16_t count;
+
+#ifdef __AVR__
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+#endif
+  {
+    sum = profileSum[phase];
+    count = profileSamples[phase];
+  }
+  return count ? sum / count : 0;
+}
+
+uint16_t profileMax( uint8_t phase )
+{
+  return profileHigh[phase];
+}
+
+uint16_t profileCount( uint8_t phase )
+{
+  return profileSamples[phase];
+}
+
+//******************************************************************************
+//* function: profileName
+//*         : copies the short name of a phase, name must hold 7 characters
+//******************************************************************************
+char *profileName( uint8_t phase, char *name )
+{
+  strcpy_P(name, profileNames[phase]);
+  return name;
+}
+
+//******************************************************************************
+//* function: profileDump
+//*         : prints the statistics and the ring buffer, oldest sample first
+//******************************************************************************
+void profileDump( void )
+{
+  char    name[7];
+  uint8_t i;
+  uint8_t index;
+
+  Serial.begin(115200);
+  Serial.println(F("phase min mean max count"));
+  for (i = 0; i < PROFILE_COUNT; i++) {
+    Serial.print(profileName(i, name));
+    Serial.print(' ');
+    Serial.print(profileMin(i));
+    Serial.print(' ');
+    Serial.print(profileMean(i));
+    Serial.print(' ');
+    Serial.print(profileMax(i));
+    Serial.print(' ');
+    Serial.println(profileCount(i));
+  }
+  Serial.print(F("ring"));
+  index = (profileHead + PROFILE_RING_SIZE - profileFill) % PROFILE_RING_SIZE;
+  for (i = 0; i < profileFill; i++) {
+    Serial.print(' ');
+    Serial.print(profileName(profileRing[index].phase, name));
+    Serial.print(':');
+    Serial.print(profileRing[index].time);
+    index = (index + 1) % PROFILE_RING_SIZE;
+  }
+  Serial.println();
+  Serial.flush();
+}
+
+#endif // PROFILE_PHASES
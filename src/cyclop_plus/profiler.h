@@ -0,0 +1,82 @@
+/*******************************************************************************
+  This is the header file for the phase profiler. When PROFILE_PHASES is
+  defined the main phases of the firmware are timed with micros(). Each
+  sample goes into a small ring buffer and into min, mean and max statistics
+  per phase. Without the define the PROFILE_ macros expand to nothing.
+
+  The MIT License (MIT)
+
+  Copyright (c) 2017 Kjell Kernen (Dvogonen)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+********************************************************************************/
+#ifndef profiler_h
+#define profiler_h
+
+#include "Arduino.h"
+
+// Uncomment to time the phases below. The statistics are shown on a hidden
+// screen: double click "Exit" in the function menu.
+//#define PROFILE_PHASES
+
+// Phases
+#define PROFILE_TUNE            0   // receiver.setFrequency()
+#define PROFILE_SETTLE          1   // retune until the RSSI has settled
+#define PROFILE_ADC_ISR         2   // ADC conversion complete interrupt
+#define PROFILE_BUTTON_ISR      3   // button timer interrupt accepting an edge
+#define PROFILE_FLUSH           4   // display.display()
+#define PROFILE_EEPROM          5   // writeEeprom()
+#define PROFILE_LOOP            6   // one pass of loop()
+#define PROFILE_DRAW_CHANNEL    7   // drawChannelScreen()
+#define PROFILE_DRAW_SCANNER    8   // drawScannerScreen()
+#define PROFILE_UPDATE_SCANNER  9   // updateScannerScreen()
+#define PROFILE_DRAW_AUTOSCAN   10  // drawAutoScanScreen()
+#define PROFILE_DRAW_FUNCTION   11  // drawFunctionScreen()
+#define PROFILE_DRAW_OPTIONS    12  // drawOptionsScreen()
+#define PROFILE_DRAW_START      13  // drawStartScreen()
+#define PROFILE_HOP             14  // first channel hop until the channel screen shows it
+#define PROFILE_UPDATE_WATERFALL 15 // updateWaterfallScreen()
+#define PROFILE_COUNT           16
+
+// Number of samples kept in the ring buffer
+#define PROFILE_RING_SIZE       32
+
+// Phases per page on the diagnostics screen
+#define DIAGNOSTICS_ROWS        6
+#define DIAGNOSTICS_PAGES       ((PROFILE_COUNT + DIAGNOSTICS_ROWS - 1) / DIAGNOSTICS_ROWS)
+
+#ifdef PROFILE_PHASES
+#define PROFILE_BEGIN(phase)    profileBegin(phase)
+#define PROFILE_END(phase)      profileEnd(phase)
+
+void     profileBegin( uint8_t phase );
+void     profileEnd( uint8_t phase );
+void     profileReset( void );
+uint16_t profileMin( uint8_t phase );
+uint16_t profileMean( uint8_t phase );
+uint16_t profileMax( uint8_t phase );
+uint16_t profileCount( uint8_t phase );
+char    *profileName( uint8_t phase, char *name );
+void     profileDump( void );
+#else
+#define PROFILE_BEGIN(phase)
+#define PROFILE_END(phase)
+#endif
+
+#endif // profiler_h
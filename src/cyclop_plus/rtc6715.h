@@ -27,15 +27,18 @@
 #ifndef rtc6715_h
 #define rtc6715_h
 
+#include "Arduino.h"
+#include "profiler.h"
+
 class rtc6715
 {
   public:
     rtc6715( unsigned int spi_clock_pin, unsigned int spi_slave_select_pin, unsigned int spi_data_pin );
     long readRegister( unsigned char reg );
     void setFrequency(unsigned int frequency);
+    static unsigned int calcFrequencyData( unsigned int frequency );
 
   private:
-    unsigned int calcFrequencyData( unsigned int frequency );
     void     spi_0(void);
     void     spi_1(void);
     void     spiEnableHigh( void );
@@ -47,4 +50,147 @@ class rtc6715
     unsigned int spi_data_pin = 0;
 };
 
+//******************************************************************************
+//* Pin specialized variant of the rtc6715 driver with the same interface.
+//* The pins are template parameters and are resolved to port registers and
+//* bit masks at compile time, so every pin change is a single sbi/cbi
+//* instruction instead of a digitalWrite() call with table lookups.
+//*
+//* The pin mapping is the one of the ATmega328 (Uno, Pro Mini):
+//* pins 0-7 are PORTD, pins 8-13 are PORTB and pins 14-19 (A0-A5) are PORTC.
+//* Other targets fall back to digitalWrite().
+//*
+//* A single instruction takes at least 125 ns, which is longer than the
+//* data setup and hold times of the RTC6715, so the clock is toggled without
+//* delays. Only the delays around the slave select edges are kept.
+//******************************************************************************
+constexpr uint8_t rtc6715_mask( uint8_t pin )
+{
+  return 1 << (pin < 8 ? pin : (pin < 14 ? pin - 8 : pin - 14));
+}
+
+template <uint8_t pin> inline void rtc6715_high( void )
+{
+#ifdef __AVR__
+  if (pin < 8)       PORTD |= rtc6715_mask(pin);
+  else if (pin < 14) PORTB |= rtc6715_mask(pin);
+  else               PORTC |= rtc6715_mask(pin);
+#else
+  digitalWrite(pin, HIGH);
+#endif
+}
+
+template <uint8_t pin> inline void rtc6715_low( void )
+{
+#ifdef __AVR__
+  if (pin < 8)       PORTD &= ~rtc6715_mask(pin);
+  else if (pin < 14) PORTB &= ~rtc6715_mask(pin);
+  else               PORTC &= ~rtc6715_mask(pin);
+#else
+  digitalWrite(pin, LOW);
+#endif
+}
+
+template <uint8_t pin> inline uint8_t rtc6715_read( void )
+{
+#ifdef __AVR__
+  if (pin < 8)       return (PIND & rtc6715_mask(pin)) != 0;
+  else if (pin < 14) return (PINB & rtc6715_mask(pin)) != 0;
+  else               return (PINC & rtc6715_mask(pin)) != 0;
+#else
+  return digitalRead(pin);
+#endif
+}
+
+template <uint8_t clockPin, uint8_t selectPin, uint8_t dataPin>
+class rtc6715_fast
+{
+  public:
+    rtc6715_fast( void )
+    {
+      pinMode(selectPin, OUTPUT);
+      pinMode(dataPin, OUTPUT);
+      pinMode(clockPin, OUTPUT);
+    }
+
+    //**************************************************************************
+    //* function: setFrequency
+    //*         : same frame as rtc6715::setFrequency, 25 bits LSB first:
+    //*         : address 0x1, write bit, 20 bits synthesizer register B
+    //**************************************************************************
+    void setFrequency( unsigned int frequency )
+    {
+      uint32_t frame;
+      uint8_t i;
+
+      PROFILE_BEGIN(PROFILE_TUNE);
+      frame = 0x1 | (1 << 4) | ((uint32_t)rtc6715::calcFrequencyData(frequency) << 5);
+
+      spiEnable();
+      for (i = 25; i; i--, frame >>= 1)
+        spiWrite(frame & 0x1);
+      spiDisable();
+
+      rtc6715_low<selectPin>();
+      rtc6715_low<clockPin>();
+      rtc6715_low<dataPin>();
+      PROFILE_END(PROFILE_TUNE);
+    }
+
+    //**************************************************************************
+    //* function: readRegister - NOT TESTED!
+    //*         : returns the 20 bit content of a register, LSB first on the bus
+    //**************************************************************************
+    long readRegister( unsigned char reg )
+    {
+      long retVal = 0;
+      uint8_t i;
+
+      spiEnable();
+      for (i = 4; i; i--, reg >>= 1)
+        spiWrite(reg & 0x1);
+      spiWrite(0); // Read
+
+      pinMode(dataPin, INPUT);
+      for (i = 0; i < 20; i++) {
+        rtc6715_high<clockPin>();
+        rtc6715_low<clockPin>();
+        if (rtc6715_read<dataPin>())
+          retVal |= 1L << i;
+      }
+      pinMode(dataPin, OUTPUT);
+      spiDisable();
+
+      return retVal;
+    }
+
+  private:
+    inline void spiWrite( uint8_t bit )
+    {
+      if (bit)
+        rtc6715_high<dataPin>();
+      else
+        rtc6715_low<dataPin>();
+      rtc6715_high<clockPin>();
+      rtc6715_low<clockPin>();
+    }
+
+    inline void spiEnable( void )
+    {
+      rtc6715_low<clockPin>();
+      rtc6715_high<selectPin>();
+      delayMicroseconds(1);
+      rtc6715_low<selectPin>();
+      delayMicroseconds(1);
+    }
+
+    inline void spiDisable( void )
+    {
+      rtc6715_low<clockPin>();
+      delayMicroseconds(1);
+      rtc6715_high<selectPin>();
+      delayMicroseconds(1);
+    }
+};
+
 #endif // rtc6715_h
@@ -0,0 +1,123 @@
+/*******************************************************************************
+  This file contains the task scheduler. It is cooperative: a task runs to
+  completion, and blocking code keeps the tasks running by calling
+  schedulerRun() while it waits.
+
+  The MIT License (MIT)
+
+  Copyright (c) 2017 Kjell Kernen (Dvogonen)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+********************************************************************************/
+// Application includes
+#include "Arduino.h"
+#include "scheduler.h"
+
+//******************************************************************************
+//* File scope variables
+
+struct schedulerTask {
+  schedulerFunction function;
+  uint32_t          due;
+  uint16_t          period;       // 0 for one-shot tasks
+  uint16_t          lateness;     // Worst lateness in ms
+  bool              active;
+};
+
+static schedulerTask schedulerTasks[SCHEDULER_TASKS];
+static uint8_t       schedulerCount = 0;
+static bool          schedulerRunning = false;
+
+//******************************************************************************
+//* function: schedulerAdd
+//*         : adds a task that first runs after delayMs and then every
+//*         : periodMs, or only once if periodMs is 0. Returns the task id.
+//******************************************************************************
+uint8_t schedulerAdd( schedulerFunction function, uint16_t delayMs, uint16_t periodMs )
+{
+  schedulerTask *task;
+
+  if (schedulerCount >= SCHEDULER_TASKS)
+    return SCHEDULER_NONE;
+  task = &schedulerTasks[schedulerCount];
+  task->function = function;
+  task->period = periodMs;
+  task->lateness = 0;
+  schedulerStart(schedulerCount, delayMs);
+  return schedulerCount++;
+}
+
+//******************************************************************************
+//* function: schedulerStart
+//*         : (re)starts a task to run delayMs from now
+//******************************************************************************
+void schedulerStart( uint8_t task, uint16_t delayMs )
+{
+  if (task >= SCHEDULER_TASKS)
+    return;
+  schedulerTasks[task].due = millis() + delayMs;
+  schedulerTasks[task].active = true;
+}
+
+//******************************************************************************
+//* function: schedulerRun
+//*         : runs the tasks that are due. Calls from within a task return
+//*         : at once.
+//******************************************************************************
+void schedulerRun( void )
+{
+  schedulerTask *task;
+  uint32_t now;
+  uint32_t late;
+  uint8_t  i;
+
+  if (schedulerRunning)
+    return;
+  schedulerRunning = true;
+  for (i = 0; i < schedulerCount; i++) {
+    task = &schedulerTasks[i];
+    now = millis();
+    if (!task->active || (int32_t)(now - task->due) < 0)
+      continue;
+
+    late = now - task->due;
+    if (late > task->lateness)
+      task->lateness = late > 0xFFFF ? 0xFFFF : late;
+
+    // Keep the period, but do not run a late task several times in a row
+    if (task->period) {
+      task->due += task->period;
+      if ((int32_t)(now - task->due) >= 0)
+        task->due = now + task->period;
+    }
+    else
+      task->active = false;
+    task->function();
+  }
+  schedulerRunning = false;
+}
+
+//******************************************************************************
+//* function: schedulerLateness
+//*         : worst time in ms a task has run after its deadline
+//******************************************************************************
+uint16_t schedulerLateness( uint8_t task )
+{
+  return task < SCHEDULER_TASKS ? schedulerTasks[task].lateness : 0;
+}
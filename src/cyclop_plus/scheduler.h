@@ -0,0 +1,46 @@
+/*******************************************************************************
+  This is the header file for the task scheduler. Tasks are plain functions
+  that run from schedulerRun() when their deadline has passed. Periodic tasks
+  are rescheduled one period after their previous deadline, one-shot tasks
+  stop after running and are started again with schedulerStart(). Deadlines
+  are compared as differences, so they keep working when millis() wraps.
+
+  The MIT License (MIT)
+
+  Copyright (c) 2017 Kjell Kernen (Dvogonen)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+********************************************************************************/
+#ifndef scheduler_h
+#define scheduler_h
+
+#include "Arduino.h"
+
+// Maximum number of tasks
+#define SCHEDULER_TASKS       8
+#define SCHEDULER_NONE        255
+
+typedef void (*schedulerFunction)( void );
+
+uint8_t  schedulerAdd( schedulerFunction function, uint16_t delayMs, uint16_t periodMs );
+void     schedulerStart( uint8_t task, uint16_t delayMs );
+void     schedulerRun( void );
+uint16_t schedulerLateness( uint8_t task );
+
+#endif // scheduler_h
@@ -0,0 +1,169 @@
+/*******************************************************************************
+  This file contains the settings store. At boot the sequence numbers of the
+  ring are scanned to find the newest record, its CRC is checked and the
+  records before it are tried if the last save was cut short. Settings of
+  firmware versions before the store are migrated from the old fixed layout.
+
+  The MIT License (MIT)
+
+  Copyright (c) 2017 Kjell Kernen (Dvogonen)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+********************************************************************************/
+// Application includes
+#include "Arduino.h"
+#include "settings.h"
+#include "eepromqueue.h"
+
+// Library includes
+#include <stddef.h>
+#include <string.h>
+#include <util/crc16.h>
+
+// Sequence numbers are compared as signed 8 bit differences
+static_assert(SETTINGS_SLOTS < 128, "settings ring too large for 8 bit sequence numbers");
+
+//******************************************************************************
+//* File scope variables
+
+static uint8_t settingsSlot = SETTINGS_SLOTS - 1;   // Slot of the newest record
+static uint8_t settingsSequence = 0xFF;
+static bool    settingsStored = false;
+
+//******************************************************************************
+//* function: settingsAddress
+//******************************************************************************
+static uint16_t settingsAddress( uint8_t slot )
+{
+  return SETTINGS_START + slot * sizeof(settingsRecord);
+}
+
+//******************************************************************************
+//* function: settingsRead
+//*         : reads a record, true if it has a known schema and a valid CRC
+//******************************************************************************
+static bool settingsRead( uint8_t slot, settingsRecord *record )
+{
+  uint8_t *bytes = (uint8_t *)record;
+  uint16_t address = settingsAddress(slot);
+  uint8_t  crc = 0;
+  uint8_t  i;
+
+  for (i = 0; i < sizeof(settingsRecord); i++)
+    bytes[i] = eepromQueueRead(address + i);
+  if (record->schema == 0 || record->schema > SETTINGS_SCHEMA)
+    return false;
+  for (i = 0; i < sizeof(settingsRecord) - 1; i++)
+    crc = _crc8_ccitt_update(crc, bytes[i]);
+  return crc == record->crc;
+}
+
+//******************************************************************************
+//* function: settingsLoad
+//*         : reads the newest record, false if there are no saved settings.
+//*         : Levels are 0 if the record has none.
+//******************************************************************************
+bool settingsLoad( uint8_t *channel, uint8_t *options, uint8_t *levels )
+{
+  settingsRecord record;
+  uint16_t address;
+  uint8_t  slot, schema, sequence, newest = 0;
+  uint8_t  i;
+  bool     found = false;
+
+  // Find the newest record by its sequence number alone. The sequence
+  // numbers of the ring span less than 128, so they compare across the wrap.
+  for (slot = 0; slot < SETTINGS_SLOTS; slot++) {
+    address = settingsAddress(slot);
+    schema = eepromQueueRead(address + offsetof(settingsRecord, schema));
+    if (schema == 0 || schema > SETTINGS_SCHEMA)
+      continue;
+    sequence = eepromQueueRead(address + offsetof(settingsRecord, sequence));
+    if (!found || (int8_t)(sequence - settingsSequence) > 0) {
+      settingsSequence = sequence;
+      newest = slot;
+      found = true;
+    }
+  }
+
+  // A save cut short leaves a bad CRC, step back to the record before it
+  for (i = 0; found && i < SETTINGS_SLOTS; i++) {
+    if (settingsRead(newest, &record) && record.sequence == settingsSequence) {
+      settingsSlot = newest;
+      settingsStored = true;
+      *channel = record.channel;
+      memcpy(options, record.options, MAX_OPTIONS);
+      // Schema 1 records had zeros in place of the levels
+      if (record.schema < 2)
+        memset(record.levels, 0, NOISE_LEVELS);
+      memcpy(levels, record.levels, NOISE_LEVELS);
+      return true;
+    }
+    newest = newest ? newest - 1 : SETTINGS_SLOTS - 1;
+    settingsSequence--;
+  }
+
+  // Settings saved by firmware before the store
+  memset(levels, 0, NOISE_LEVELS);
+  settingsSlot = SETTINGS_SLOTS - 1;
+  settingsSequence = 0xFF;
+  if (eepromQueueRead(EEPROM_CHECK) != VER_EEPROM)
+    return false;
+  *channel = eepromQueueRead(EEPROM_CHANNEL);
+  for (i = 0; i < MAX_OPTIONS; i++)
+    options[i] = eepromQueueRead(EEPROM_OPTIONS + i);
+  return true;
+}
+
+//******************************************************************************
+//* function: settingsSave
+//*         : appends a record if the settings differ from the newest one,
+//*         : true if a record was written
+//******************************************************************************
+bool settingsSave( uint8_t channel, const uint8_t *options, const uint8_t *levels )
+{
+  settingsRecord record;
+  uint8_t *bytes = (uint8_t *)&record;
+  uint16_t address;
+  uint8_t  i;
+
+  if (settingsStored && settingsRead(settingsSlot, &record) &&
+      record.channel == channel && !memcmp(record.options, options, MAX_OPTIONS) &&
+      !memcmp(record.levels, levels, NOISE_LEVELS))
+    return false;
+
+  memset(&record, 0, sizeof(record));
+  record.schema = SETTINGS_SCHEMA;
+  record.sequence = ++settingsSequence;
+  record.channel = channel;
+  memcpy(record.options, options, MAX_OPTIONS);
+  memcpy(record.levels, levels, NOISE_LEVELS);
+  for (i = 0; i < sizeof(settingsRecord) - 1; i++)
+    record.crc = _crc8_ccitt_update(record.crc, bytes[i]);
+
+  // The bytes are programmed in the background. Bytes that already hold the
+  // right value are skipped. The CRC goes last, so the record only becomes
+  // valid when it is complete.
+  settingsSlot = settingsSlot + 1 < SETTINGS_SLOTS ? settingsSlot + 1 : 0;
+  address = settingsAddress(settingsSlot);
+  for (i = 0; i < sizeof(settingsRecord); i++)
+    eepromQueueWrite(address + i, bytes[i]);
+  settingsStored = true;
+  return true;
+}
@@ -0,0 +1,62 @@
+/*******************************************************************************
+  This is the header file for the settings store. The channel and the options
+  are saved as records in a ring in EEPROM. Each save appends a record with
+  the next sequence number and a CRC, so the cells wear evenly and a save
+  that is cut short by a power loss leaves the previous record intact. A
+  record is only written when a value has changed.
+
+  The MIT License (MIT)
+
+  Copyright (c) 2017 Kjell Kernen (Dvogonen)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+********************************************************************************/
+#ifndef settings_h
+#define settings_h
+
+#include "Arduino.h"
+#include "cyclop_plus.h"
+#include "noisefloor.h"
+
+// EEPROM area of the ring, the bytes below it hold the old fixed layout
+#define SETTINGS_START          16
+#define SETTINGS_END            1024
+
+// Increase when fields are added to the record. Fields are added in the
+// reserved bytes, and records of older schemas are upgraded on load by
+// giving the new fields their default values.
+#define SETTINGS_SCHEMA         2
+#define SETTINGS_RESERVED       1
+
+struct settingsRecord {
+  uint8_t schema;
+  uint8_t sequence;
+  uint8_t channel;
+  uint8_t options[MAX_OPTIONS];
+  uint8_t levels[NOISE_LEVELS];     // Schema 2, the learned noise levels
+  uint8_t reserved[SETTINGS_RESERVED];
+  uint8_t crc;
+};
+
+#define SETTINGS_SLOTS          ((uint8_t)((SETTINGS_END - SETTINGS_START) / sizeof(settingsRecord)))
+
+bool settingsLoad( uint8_t *channel, uint8_t *options, uint8_t *levels );
+bool settingsSave( uint8_t channel, const uint8_t *options, const uint8_t *levels );
+
+#endif // settings_h
@@ -0,0 +1,198 @@
+/*******************************************************************************
+  This is the spectrum store. The scanners write every RSSI sample to it and
+  the graphic scanner renders from it. The auto scanner uses it to find known
+  peaks without sweeping the band again.
+
+  The MIT License (MIT)
+
+  Copyright (c) 2017 Kjell Kernen (Dvogonen)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+********************************************************************************/
+// Application includes
+#include "Arduino.h"
+#include "spectrum.h"
+
+//******************************************************************************
+//* File scope variables
+
+static uint8_t  spectrumCur[SPECTRUM_COLUMNS];
+static uint8_t  spectrumMax[SPECTRUM_COLUMNS];
+static uint8_t  spectrumAvg[SPECTRUM_COLUMNS];
+static uint16_t spectrumMin = 0;
+static uint16_t spectrumSpan = 0;
+static uint8_t  spectrumSweepCount = 0;
+static uint32_t spectrumSwept = 0;
+
+//******************************************************************************
+//* function: spectrumReset
+//*         : clears the store and sets the frequency range it covers
+//******************************************************************************
+void spectrumReset( uint16_t frequencyMin, uint16_t frequencyMax )
+{
+  memset(spectrumCur, 0, sizeof(spectrumCur));
+  memset(spectrumMax, 0, sizeof(spectrumMax));
+  memset(spectrumAvg, 0, sizeof(spectrumAvg));
+  spectrumMin = frequencyMin;
+  spectrumSpan = frequencyMax - frequencyMin;
+  spectrumSweepCount = 0;
+}
+
+//******************************************************************************
+//* function: spectrumMatches
+//*         : true if the store covers the given frequency range
+//******************************************************************************
+bool spectrumMatches( uint16_t frequencyMin, uint16_t frequencyMax )
+{
+  return spectrumMin == frequencyMin && spectrumSpan == (frequencyMax - frequencyMin);
+}
+
+//******************************************************************************
+//* function: spectrumColumn
+//*         : returns the column of a frequency, or 255 if it is out of range
+//******************************************************************************
+uint8_t spectrumColumn( uint16_t frequency )
+{
+  uint16_t column;
+
+  if (!spectrumSpan || frequency < spectrumMin || frequency > spectrumMin + spectrumSpan)
+    return 255;
+  column = (uint32_t)(frequency - spectrumMin) * SPECTRUM_COLUMNS / spectrumSpan;
+  return column < SPECTRUM_COLUMNS ? column : SPECTRUM_COLUMNS - 1;
+}
+
+//******************************************************************************
+//* function: spectrumFrequency
+//*         : returns the center frequency of a column
+//******************************************************************************
+uint16_t spectrumFrequency( uint8_t column )
+{
+  return spectrumMin + ((uint32_t)column * 2 + 1) * spectrumSpan / (SPECTRUM_COLUMNS * 2);
+}
+
+//******************************************************************************
+//* function: spectrumStore
+//*         : updates the current, peak and average value of a column
+//******************************************************************************
+void spectrumStore( uint16_t frequency, uint16_t rssi )
+{
+  uint8_t column = spectrumColumn(frequency);
+  uint8_t value = rssi > 1023 ? 255 : rssi >> 2;
+
+  if (column == 255)
+    return;
+
+  spectrumCur[column] = value;
+  if (value > spectrumMax[column])
+    spectrumMax[column] = value;
+  if (!spectrumAvg[column])
+    spectrumAvg[column] = value;
+  else
+    spectrumAvg[column] += ((int16_t)value - spectrumAvg[column]) >> SPECTRUM_AVERAGE_SHIFT;
+}
+
+//******************************************************************************
+//* function: spectrumSweepDone
+//*         : called when a complete sweep of the range has been stored
+//******************************************************************************
+void spectrumSweepDone( void )
+{
+  if (spectrumSweepCount < 255)
+    spectrumSweepCount++;
+  spectrumSwept = millis();
+}
+
+//******************************************************************************
+//* function: spectrumSweeps
+//*         : returns the number of complete sweeps since the last reset
+//******************************************************************************
+uint8_t spectrumSweeps( void )
+{
+  return spectrumSweepCount;
+}
+
+//******************************************************************************
+//* function: spectrumAge
+//*         : returns the time in milliseconds since the last complete sweep.
+//*         : Samples stored by an auto scan do not count, they only cover
+//*         : part of the range.
+//******************************************************************************
+uint32_t spectrumAge( void )
+{
+  return millis() - spectrumSwept;
+}
+
+uint8_t spectrumCurrent( uint8_t column )
+{
+  return spectrumCur[column];
+}
+
+uint8_t spectrumPeak( uint8_t column )
+{
+  return spectrumMax[column];
+}
+
+uint8_t spectrumAverage( uint8_t column )
+{
+  return spectrumAvg[column];
+}
+
+//******************************************************************************
+//* function: spectrumRssi
+//*         : returns the average RSSI at a frequency, 0 if it is not known
+//******************************************************************************
+uint16_t spectrumRssi( uint16_t frequency )
+{
+  uint8_t column = spectrumColumn(frequency);
+
+  if (column == 255)
+    return 0;
+  return (uint16_t)spectrumAvg[column] << 2;
+}
+
+//******************************************************************************
+//* function: spectrumNextPeak
+//*         : returns the first column after the given one, wrapping around,
+//*         : that is a local maximum with a current value of at least level.
+//*         : If the given column reaches level, a peak only counts after a
+//*         : column below leave, so the signal it is on is skipped. Returns
+//*         : 255 if there is none.
+//******************************************************************************
+uint8_t spectrumNextPeak( uint8_t column, uint8_t level, uint8_t leave )
+{
+  uint8_t i;
+  uint8_t value;
+  bool    armed = column >= SPECTRUM_COLUMNS || spectrumCur[column] < level;
+
+  for (i = 1; i <= SPECTRUM_COLUMNS; i++) {
+    if (++column >= SPECTRUM_COLUMNS)
+      column = 0;
+    value = spectrumCur[column];
+    if (value < leave)
+      armed = true;
+    if (!armed || value < level)
+      continue;
+    if (column > 0 && spectrumCur[column - 1] > value)
+      continue;
+    if (column < SPECTRUM_COLUMNS - 1 && spectrumCur[column + 1] >= value)
+      continue;
+    return column;
+  }
+  return 255;
+}
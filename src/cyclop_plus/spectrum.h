@@ -0,0 +1,54 @@
+/*******************************************************************************
+  This is the header file for the spectrum store. It keeps the RSSI of the
+  band in 100 columns, one per column of the graphic scanner. Each column
+  holds the latest value, a peak hold value and an exponential average.
+  Values are stored as RSSI / 4 to fit a byte.
+
+  The MIT License (MIT)
+
+  Copyright (c) 2017 Kjell Kernen (Dvogonen)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+********************************************************************************/
+#ifndef spectrum_h
+#define spectrum_h
+
+#include "Arduino.h"
+
+#define SPECTRUM_COLUMNS      100
+
+// Weight of a new sample in the average, as a right shift (1/4)
+#define SPECTRUM_AVERAGE_SHIFT  2
+
+void     spectrumReset( uint16_t frequencyMin, uint16_t frequencyMax );
+bool     spectrumMatches( uint16_t frequencyMin, uint16_t frequencyMax );
+void     spectrumStore( uint16_t frequency, uint16_t rssi );
+void     spectrumSweepDone( void );
+uint8_t  spectrumSweeps( void );
+uint32_t spectrumAge( void );
+
+uint8_t  spectrumColumn( uint16_t frequency );
+uint16_t spectrumFrequency( uint8_t column );
+uint8_t  spectrumCurrent( uint8_t column );
+uint8_t  spectrumPeak( uint8_t column );
+uint8_t  spectrumAverage( uint8_t column );
+uint16_t spectrumRssi( uint16_t frequency );
+uint8_t  spectrumNextPeak( uint8_t column, uint8_t level, uint8_t leave );
+
+#endif // spectrum_h
@@ -0,0 +1,124 @@
+/*******************************************************************************
+  This file contains the spectrum streaming. Frames are built in a small
+  buffer and handed to the interrupt driven transmit buffer of Serial in one
+  go, or dropped if the buffer is too full to take the whole frame.
+
+  The MIT License (MIT)
+
+  Copyright (c) 2017 Kjell Kernen (Dvogonen)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+********************************************************************************/
+// Application includes
+#include "Arduino.h"
+#include "stream.h"
+
+#ifdef STREAM_SPECTRUM
+
+//******************************************************************************
+//* File scope variables
+
+static uint16_t streamLost = 0;       // Dropped since the last sweep frame
+static uint16_t streamLostTotal = 0;
+
+//******************************************************************************
+//* function: streamCrc
+//*         : CRC-8 with polynomial 0x07 of the bytes after the sync byte
+//******************************************************************************
+static uint8_t streamCrc( const uint8_t *data, uint8_t length )
+{
+  uint8_t crc = 0;
+  uint8_t i;
+
+  while (length--) {
+    crc ^= *data++;
+    for (i = 0; i < 8; i++)
+      crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+  }
+  return crc;
+}
+
+//******************************************************************************
+//* function: streamSend
+//*         : adds the checksum and queues a frame, false if it was dropped
+//******************************************************************************
+static bool streamSend( uint8_t *frame, uint8_t size )
+{
+  if (Serial.availableForWrite() < size) {
+    if (streamLost < 0xFFFF)
+      streamLost++;
+    if (streamLostTotal < 0xFFFF)
+      streamLostTotal++;
+    return false;
+  }
+  frame[size - 1] = streamCrc(frame + 1, size - 2);
+  Serial.write(frame, size);
+  return true;
+}
+
+//******************************************************************************
+//* function: streamBegin
+//******************************************************************************
+void streamBegin( void )
+{
+  Serial.begin(STREAM_BAUD);
+}
+
+//******************************************************************************
+//* function: streamSweep
+//*         : marks the start of a sweep
+//******************************************************************************
+void streamSweep( uint16_t frequencyMin, uint16_t frequencyMax, uint8_t step )
+{
+  uint8_t frame[STREAM_SWEEP_SIZE] = {
+    STREAM_SYNC, STREAM_SWEEP,
+    (uint8_t)frequencyMin, (uint8_t)(frequencyMin >> 8),
+    (uint8_t)frequencyMax, (uint8_t)(frequencyMax >> 8),
+    step,
+    (uint8_t)streamLost, (uint8_t)(streamLost >> 8)
+  };
+
+  if (streamSend(frame, STREAM_SWEEP_SIZE))
+    streamLost = 0;
+}
+
+//******************************************************************************
+//* function: streamSample
+//******************************************************************************
+void streamSample( uint16_t frequency, uint16_t rssi )
+{
+  uint8_t frame[STREAM_SAMPLE_SIZE] = {
+    STREAM_SYNC, STREAM_SAMPLE,
+    (uint8_t)frequency, (uint8_t)(frequency >> 8),
+    (uint8_t)rssi, (uint8_t)(rssi >> 8)
+  };
+
+  streamSend(frame, STREAM_SAMPLE_SIZE);
+}
+
+//******************************************************************************
+//* function: streamDropped
+//*         : number of frames dropped since streamBegin, saturated
+//******************************************************************************
+uint16_t streamDropped( void )
+{
+  return streamLostTotal;
+}
+
+#endif // STREAM_SPECTRUM
@@ -0,0 +1,63 @@
+/*******************************************************************************
+  This is the header file for spectrum streaming. When STREAM_SPECTRUM is
+  defined every sample of the graphic scanner is also sent as a small binary
+  frame on the serial port. Frames are only queued when the transmit buffer
+  has room for them, so streaming never slows down a sweep. Frames that do
+  not fit are dropped and counted. src/tools/spectrum_plot.py decodes and
+  plots the stream on a PC.
+
+  The MIT License (MIT)
+
+  Copyright (c) 2017 Kjell Kernen (Dvogonen)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+********************************************************************************/
+#ifndef stream_h
+#define stream_h
+
+#include "Arduino.h"
+
+// Uncomment to stream the graphic scanner samples on the serial port.
+// 500000 baud is exact at 8 MHz. The port is shared with the debug output
+// of PRINT_SETTLE_TIMES and PROFILE_PHASES, do not enable them together.
+//#define STREAM_SPECTRUM
+#define STREAM_BAUD             500000
+
+// Frame layout, multi byte values are little endian. The checksum is a
+// CRC-8 (polynomial 0x07) of all bytes between the sync byte and itself.
+//
+//   sweep:  A5 'S' min:2 max:2 step:1 dropped:2 crc:1
+//   sample: A5 'R' frequency:2 rssi:2 crc:1
+//
+// A sweep frame starts each sweep. It carries the scanned range in MHz and
+// the number of frames dropped since the previous sweep frame.
+#define STREAM_SYNC             0xA5
+#define STREAM_SWEEP            'S'
+#define STREAM_SAMPLE           'R'
+#define STREAM_SWEEP_SIZE       10
+#define STREAM_SAMPLE_SIZE      7
+
+#ifdef STREAM_SPECTRUM
+void     streamBegin( void );
+void     streamSweep( uint16_t frequencyMin, uint16_t frequencyMax, uint8_t step );
+void     streamSample( uint16_t frequency, uint16_t rssi );
+uint16_t streamDropped( void );
+#endif
+
+#endif // stream_h
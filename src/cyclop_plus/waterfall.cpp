@@ -0,0 +1,160 @@
+/*******************************************************************************
+  This file contains the waterfall. Each completed sweep of the graphic
+  scanner adds a row of 2 bit levels, four columns to the byte, to a ring
+  that the caller provides. Rows are drawn one line above the last one, and
+  the display start line follows, so the newest sweep is on top and the rest
+  move down without being sent again. The levels are shown as 0, 1/4, 1/2 and
+  all pixels lit with a 2 by 2 ordered dither.
+
+  The MIT License (MIT)
+
+  Copyright (c) 2017 Kjell Kernen (Dvogonen)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+********************************************************************************/
+// Application includes
+#include "Arduino.h"
+#include "waterfall.h"
+#include "noisefloor.h"
+
+//******************************************************************************
+//* File scope variables
+
+static uint8_t *waterfallRows;          // rows * WATERFALL_ROW_BYTES
+static uint8_t  waterfallSize = 0;      // rows in the ring
+static uint8_t  waterfallFill = 0;      // rows that hold a sweep
+static uint8_t  waterfallNewest = 0;    // ring index of the newest row
+static uint8_t  waterfallTop = 0;       // display line of the newest row
+
+// Thresholds of the 2 by 2 ordered dither, by the low bits of line and column
+static const uint8_t waterfallDither[4] PROGMEM = { 0, 2, 3, 1 };
+
+//******************************************************************************
+//* function: waterfallQuantize
+//*         : maps a spectrum value to a level of 0 to 3
+//******************************************************************************
+static uint8_t waterfallQuantize( uint8_t value )
+{
+  uint8_t level = noiseLevel((uint16_t)value << 2);
+
+  if (level >= WATERFALL_LEVEL_3)
+    return 3;
+  if (level >= WATERFALL_LEVEL_2)
+    return 2;
+  return level >= WATERFALL_LEVEL_1 ? 1 : 0;
+}
+
+//******************************************************************************
+//* function: waterfallBegin
+//*         : starts an empty waterfall at display line 0. The ring has room
+//*         : for rows rows of WATERFALL_ROW_BYTES each.
+//******************************************************************************
+void waterfallBegin( uint8_t *history, uint8_t rows )
+{
+  waterfallRows = history;
+  waterfallSize = rows;
+  waterfallFill = 0;
+  waterfallNewest = 0;
+  waterfallTop = 0;
+}
+
+//******************************************************************************
+//* function: waterfallAdd
+//*         : adds the current sweep of the spectrum as the newest row, on
+//*         : the display line above the last one
+//******************************************************************************
+void waterfallAdd( void )
+{
+  uint8_t *row;
+  uint8_t  column;
+
+  waterfallNewest = waterfallNewest ? waterfallNewest - 1 : waterfallSize - 1;
+  if (waterfallFill < waterfallSize)
+    waterfallFill++;
+  waterfallTop = (waterfallTop - 1) & (WATERFALL_LINES - 1);
+
+  row = waterfallRows + waterfallNewest * WATERFALL_ROW_BYTES;
+  memset(row, 0, WATERFALL_ROW_BYTES);
+  for (column = 0; column < SPECTRUM_COLUMNS; column++)
+    row[column >> 2] |= waterfallQuantize(spectrumCurrent(column)) << ((column & 3) << 1);
+}
+
+//******************************************************************************
+//* function: waterfallLine
+//*         : returns the display line of the newest row
+//******************************************************************************
+uint8_t waterfallLine( void )
+{
+  return waterfallTop;
+}
+
+//******************************************************************************
+//* function: waterfallStartLine
+//*         : returns the start line that shows the newest row on top. Lines
+//*         : are display coordinates, flip is set for a rotation of 180
+//*         : degrees, which turns the display RAM upside down.
+//******************************************************************************
+uint8_t waterfallStartLine( bool flip )
+{
+  return flip ? (WATERFALL_LINES - waterfallTop) & (WATERFALL_LINES - 1) : waterfallTop;
+}
+
+//******************************************************************************
+//* function: waterfallLevel
+//*         : returns the level of a column age sweeps ago, 0 for rows that
+//*         : are no longer kept
+//******************************************************************************
+uint8_t waterfallLevel( uint8_t age, uint8_t column )
+{
+  uint8_t index;
+
+  if (age >= waterfallFill || column >= SPECTRUM_COLUMNS)
+    return 0;
+  index = waterfallNewest + age;
+  if (index >= waterfallSize)
+    index -= waterfallSize;
+  return (waterfallRows[index * WATERFALL_ROW_BYTES + (column >> 2)] >> ((column & 3) << 1)) & 3;
+}
+
+//******************************************************************************
+//* function: waterfallDot
+//*         : returns true if the pixel of a column on a display line is lit
+//*         : for a level
+//******************************************************************************
+bool waterfallDot( uint8_t column, uint8_t line, uint8_t level )
+{
+  return level == 3 || level > pgm_read_byte(&waterfallDither[(column & 1) | ((line & 1) << 1)]);
+}
+
+//******************************************************************************
+//* function: waterfallBits
+//*         : one byte of a column for a page of 8 display lines, LSB on top.
+//*         : Lines whose rows are no longer kept are left dark.
+//******************************************************************************
+uint8_t waterfallBits( uint8_t column, uint8_t page )
+{
+  uint8_t line = page * 8;
+  uint8_t bits = 0;
+  uint8_t i;
+
+  for (i = 0; i < 8; i++, line++)
+    if (waterfallDot(column, line, waterfallLevel((line - waterfallTop) & (WATERFALL_LINES - 1), column)))
+      bits |= 1 << i;
+  return bits;
+}
@@ -0,0 +1,59 @@
+/*******************************************************************************
+  This is the header file for the waterfall. It keeps the latest sweeps of
+  the spectrum as rows of 2 bit levels and dithers them to pixels. The
+  display scrolls by its start line register, so each sweep only writes its
+  own row.
+
+  The MIT License (MIT)
+
+  Copyright (c) 2017 Kjell Kernen (Dvogonen)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+********************************************************************************/
+#ifndef waterfall_h
+#define waterfall_h
+
+#include "Arduino.h"
+#include "spectrum.h"
+
+// Rows of the display RAM, the range the start line register scrolls over
+#define WATERFALL_LINES       64
+
+// Bytes of a row of levels, four columns per byte
+#define WATERFALL_ROW_BYTES   ((SPECTRUM_COLUMNS + 3) / 4)
+
+// Rows to keep when the display has no framebuffer. A new row is drawn by
+// rendering the whole page of 8 lines it falls in.
+#define WATERFALL_PAGE_ROWS   8
+
+// A sweep is shown at the highest of the levels 0 to 3 whose noise level
+// (64 at the learned ceiling) it reaches
+#define WATERFALL_LEVEL_1     12
+#define WATERFALL_LEVEL_2     28
+#define WATERFALL_LEVEL_3     48
+
+void    waterfallBegin( uint8_t *history, uint8_t rows );
+void    waterfallAdd( void );
+uint8_t waterfallLine( void );
+uint8_t waterfallStartLine( bool flip );
+uint8_t waterfallLevel( uint8_t age, uint8_t column );
+bool    waterfallDot( uint8_t column, uint8_t line, uint8_t level );
+uint8_t waterfallBits( uint8_t column, uint8_t page );
+
+#endif // waterfall_h
@@ -0,0 +1,55 @@
+/*******************************************************************************
+  This file contains the screen widgets.
+
+  The MIT License (MIT)
+
+  Copyright (c) 2017 Kjell Kernen (Dvogonen)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+********************************************************************************/
+// Application includes
+#include "Arduino.h"
+#include "widgets.h"
+
+//******************************************************************************
+//* function: widgetUpdate
+//*         : returns false if the widget already shows the value. Otherwise
+//*         : clears the widget, sets the cursor to its top left corner and
+//*         : its text size, and returns true. The caller then draws the value.
+//******************************************************************************
+bool widgetUpdate( Adafruit_GFX *gfx, widget *w, uint16_t value )
+{
+  if (w->shown && w->value == value)
+    return false;
+  w->value = value;
+  w->shown = true;
+  gfx->fillRect(w->x, w->y, w->width, w->height, WIDGET_BACKGROUND);
+  gfx->setCursor(w->x, w->y);
+  gfx->setTextSize(w->textSize);
+  return true;
+}
+
+//******************************************************************************
+//* function: widgetInvalidate
+//*         : forces a redraw on the next update, after the screen was cleared
+//******************************************************************************
+void widgetInvalidate( widget *w )
+{
+  w->shown = false;
+}
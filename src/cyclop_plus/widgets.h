@@ -0,0 +1,49 @@
+/*******************************************************************************
+  This is the header file for screen widgets. A widget is a rectangle of the
+  screen that shows one value. It remembers the value it shows, and is only
+  cleared and drawn again when the value changes. Drivers that track dirty
+  pages then only send the pages of the changed widgets to the display.
+
+  The MIT License (MIT)
+
+  Copyright (c) 2017 Kjell Kernen (Dvogonen)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+********************************************************************************/
+#ifndef widgets_h
+#define widgets_h
+
+#include "Arduino.h"
+#include <Adafruit_GFX.h>
+
+// Color of the widget background, BLACK in the display drivers
+#define WIDGET_BACKGROUND     0
+
+struct widget {
+  uint8_t  x, y;
+  uint8_t  width, height;
+  uint8_t  textSize;
+  uint16_t value;
+  bool     shown;
+};
+
+bool widgetUpdate( Adafruit_GFX *gfx, widget *w, uint16_t value );
+void widgetInvalidate( widget *w );
+
+#endif // widgets_h
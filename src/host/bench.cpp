@@ -0,0 +1,372 @@
+/*******************************************************************************
+  This file contains the scan benchmark of the CYCLOP+ host simulator. It runs
+  the scan engine of the sketch against one scene and prints one line of
+  key=value pairs:
+
+    scenario            name of the scene file
+    sweep_ms            virtual time of one graphic scanner sweep
+    sweep_retunes       retunes per sweep
+    sweep_adc_samples   ADC conversions per sweep
+    sweep_display_bytes display RAM bytes flushed per sweep
+    waterfall_display_bytes
+                        display RAM bytes flushed per sweep of the waterfall
+    cold_*              auto scans started from 8 points across the band with
+                        no stored spectrum: mean lock time, locks on the
+                        expected transmitter and mean error of those locks
+    warm_*              the same right after a full sweep
+
+  The expected transmitter is the first one above the start frequency whose
+  peak reaches the enter level the receiver has learned when the scan starts.
+  Scenes without one count every lock as good.
+  The low band is enabled when the scene has a transmitter below it. With -v
+each auto scan is listed on stderr. A build with PROFILE=1 also lists the
+  phase profiler statistics there. The serial port output is dropped.
+
+  With -t the text drawing of the SH1106 driver is timed instead, with the
+  page aligned text path on and off, in host CPU time per pass over a set of
+  screen texts. The line also tells if both paths gave the same display.
+  A build with PAGES=1 adds the peak use of the display list of the page
+  buffer driver to the line of each scene.
+
+  The MIT License (MIT)
+
+  Copyright (c) 2017 Kjell Kernen (Dvogonen)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+********************************************************************************/
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "Arduino.h"
+#include "sim.h"
+#include "cyclop_plus.h"
+#include "spectrum.h"
+#include "noisefloor.h"
+#include "profiler.h"
+#include "Adafruit_SH1106.h"
+
+// Sketch internals driven by the benchmark
+void setup( void );
+void graphicScanner( uint16_t frequency );
+void waterfallScanner( uint16_t frequency );
+void autoScan( uint16_t frequency );
+void scanCancel( void );
+void updateBands( void );
+extern uint8_t options[];
+extern uint8_t scanMode;
+extern Adafruit_SH1106 display;
+
+#define BENCH_SWEEPS          3
+#define BENCH_STARTS          8
+#define BENCH_TIMEOUT_MS      20000
+#define LOCK_TOLERANCE_MHZ    5
+#define BENCH_TEXT_PASSES     2000
+
+struct benchLocks {
+  double   timeMs;
+  uint8_t  good;
+  double   errorMhz;
+};
+
+static uint32_t benchMillis( void )
+{
+  return (uint32_t)(simNanos() / 1000000ULL);
+}
+
+//******************************************************************************
+//* function: runWhile
+//*         : runs loop() while the scan engine is in a mode, or times out
+//******************************************************************************
+static bool runWhile( bool (*busy)(void) )
+{
+  uint32_t start = benchMillis();
+
+  while (busy()) {
+    if (benchMillis() - start > BENCH_TIMEOUT_MS)
+      return false;
+    simStep();
+  }
+  return true;
+}
+
+static uint8_t sweepTarget;
+static bool    verbose = false;
+
+static bool sweeping( void )
+{
+  return spectrumSweeps() < sweepTarget;
+}
+
+static bool scanning( void )
+{
+  return scanMode != SCAN_IDLE;
+}
+
+//******************************************************************************
+//* function: expectedLock
+//*         : the transmitter an auto scan from start should find, 0 if none
+//******************************************************************************
+static uint16_t expectedLock( uint16_t start )
+{
+  uint32_t span = FREQUENCY_MAX - FREQUENCY_MIN;
+  uint32_t best = span + 1;
+  uint16_t expected = 0;
+  uint8_t  i;
+
+  start += SCANNING_STEP;
+  for (i = 0; i < simTransmitterCount(); i++) {
+    const simTransmitter *t = simTransmitterAt(i);
+    if (simNoiseFloor() + t->power < noiseEnter())
+      continue;
+    if (t->frequency < FREQUENCY_MIN || t->frequency > FREQUENCY_MAX)
+      continue;
+    uint32_t distance = ((uint32_t)t->frequency + span - start) % span;
+    if (distance < best) {
+      best = distance;
+      expected = (uint16_t)lround(t->frequency);
+    }
+  }
+  return expected;
+}
+
+//******************************************************************************
+//* function: measureLocks
+//*         : auto scans from evenly spread start frequencies
+//******************************************************************************
+static bool measureLocks( bool warm, benchLocks *result )
+{
+  uint8_t  i;
+  uint8_t  locks = 0;
+
+  memset(result, 0, sizeof(*result));
+  for (i = 0; i < BENCH_STARTS; i++) {
+    uint16_t start = FREQUENCY_MIN + (uint32_t)(FREQUENCY_MAX - FREQUENCY_MIN) * i / BENCH_STARTS;
+    uint16_t expected = expectedLock(start);
+
+    if (warm) {
+      sweepTarget = spectrumSweeps() + 1;
+      graphicScanner(start);
+      if (!runWhile(sweeping))
+        return false;
+      scanCancel();
+    }
+    else
+      spectrumReset(0, 0);
+
+    uint64_t begin = simNanos();
+    autoScan(start);
+    if (!runWhile(scanning))
+      return false;
+    result->timeMs += (simNanos() - begin) / 1e6;
+
+    int16_t error = (int16_t)simTunedFrequency() - (int16_t)expected;
+    if (verbose)
+      fprintf(stderr, "%s start %u expected %u locked %u in %.1f ms\n", warm ? "warm" : "cold",
+              start, expected, simTunedFrequency(), (simNanos() - begin) / 1e6);
+    if (!expected)
+      result->good++;
+    else if (abs(error) <= LOCK_TOLERANCE_MHZ) {
+      result->good++;
+      result->errorMhz += abs(error);
+      locks++;
+    }
+  }
+  result->timeMs /= BENCH_STARTS;
+  if (locks)
+    result->errorMhz /= locks;
+  return true;
+}
+
+#ifdef PROFILE_PHASES
+//******************************************************************************
+//* function: printProfile
+//*         : lists the phase profiler statistics of the run on stderr
+//******************************************************************************
+static void printProfile( void )
+{
+  char    name[7];
+  uint8_t phase;
+
+  for (phase = 0; phase < PROFILE_COUNT; phase++)
+    if (profileCount(phase))
+      fprintf(stderr, "  %-6s n=%-5u min=%-5u mean=%-5u max=%u us\n", profileName(phase, name),
+              profileCount(phase), profileMin(phase), profileMean(phase), profileMax(phase));
+}
+#endif
+
+#ifdef SH1106_FAST_TEXT
+//******************************************************************************
+//* function: drawTexts
+//*         : the texts of the channel, options and diagnostics screens, in
+//*         : both rotations and with and without background, plus a few
+//*         : off the page boundary that GFX always draws
+//******************************************************************************
+static void drawTexts( void )
+{
+  uint8_t rotation, row;
+
+  for (rotation = 0; rotation <= 2; rotation += 2) {
+    display.setRotation(rotation);
+    display.setTextColor(WHITE);
+    display.setTextSize(3);
+    display.setCursor(10, 0);
+    display.print(5865);
+    display.setTextSize(2);
+    display.setCursor(24, 40);
+    display.print("F4");
+    display.setCursor(72, 40);
+    display.print("87%");
+    display.setTextSize(1);
+    display.setCursor(0, 57);
+    display.print("5645 5732 5769 5806 5843");
+    for (row = 0; row < 8; row++) {
+      display.setCursor(0, row * 8);
+      display.setTextColor(row & 1 ? BLACK : WHITE, row & 1 ? WHITE : BLACK);
+      display.print("OPTION ");
+      display.print(row);
+      display.setCursor(17 * 6, row * 8);
+      display.print("ON ");
+    }
+    display.setTextColor(BLACK);
+    display.setCursor(40, 16);
+    display.print("xy");
+    display.setTextColor(WHITE, BLACK);
+    display.setCursor(3, 27);
+    display.print("CYCLOP+");
+  }
+  display.setRotation(0);
+}
+
+//******************************************************************************
+//* function: benchText
+//*         : times drawTexts() and grabs the display it leaves
+//******************************************************************************
+static double benchText( bool fast, uint8_t ram[8][128] )
+{
+  struct timespec begin, end;
+  uint16_t i;
+
+  display.setFastText(fast);
+  display.clearDisplay();
+  display.display();
+  drawTexts();
+  display.display();
+  display.waitFlush();
+  simCopyScreen(ram);
+
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &begin);
+  for (i = 0; i < BENCH_TEXT_PASSES; i++)
+    drawTexts();
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &end);
+  display.setFastText(true);
+  return ((end.tv_sec - begin.tv_sec) * 1e9 + (end.tv_nsec - begin.tv_nsec)) / 1e3 / BENCH_TEXT_PASSES;
+}
+#endif
+
+int main( int argc, char *argv[] )
+{
+  const char  *name;
+  simCounters  before;
+  uint64_t     begin;
+  benchLocks   cold, warm;
+  uint8_t      i;
+
+#ifdef SH1106_FAST_TEXT
+  if (argc == 2 && !strcmp(argv[1], "-t")) {
+    uint8_t gfxRam[8][128], fastRam[8][128];
+    double  gfxUs, fastUs;
+
+    setup();
+    gfxUs = benchText(false, gfxRam);
+    fastUs = benchText(true, fastRam);
+    printf("text_gfx_us=%.1f text_fast_us=%.1f text_speedup=%.1f text_identical=%s\n", gfxUs, fastUs,
+           gfxUs / fastUs, memcmp(gfxRam, fastRam, sizeof(gfxRam)) ? "no" : "yes");
+    return memcmp(gfxRam, fastRam, sizeof(gfxRam)) ? 1 : 0;
+  }
+#endif
+  if (argc == 3 && !strcmp(argv[1], "-v")) {
+    verbose = true;
+    argv++;
+    argc--;
+  }
+  if (argc != 2 || !simLoadScene(argv[1])) {
+    fprintf(stderr, "usage: %s [-v] scene | -t\n", argv[0]);
+    return 2;
+  }
+  name = strrchr(argv[1], '/') ? strrchr(argv[1], '/') + 1 : argv[1];
+
+  setup();
+  options[L_BAND_OPTION] = 0;
+  for (i = 0; i < simTransmitterCount(); i++)
+    if (simTransmitterAt(i)->frequency < 5645)
+      options[L_BAND_OPTION] = 1;
+  updateBands();
+
+  // Let the first sweep fill the pipeline, then time the following ones
+  sweepTarget = 1;
+  graphicScanner(FREQUENCY_MIN);
+  if (!runWhile(sweeping))
+    goto timeout;
+  before = simCount;
+  begin = simNanos();
+  sweepTarget = 1 + BENCH_SWEEPS;
+  if (!runWhile(sweeping))
+    goto timeout;
+  scanCancel();
+
+  printf("scenario=%.*s", (int)(strcspn(name, ".")), name);
+  printf(" sweep_ms=%.1f", (simNanos() - begin) / 1e6 / BENCH_SWEEPS);
+  printf(" sweep_retunes=%u", (simCount.retunes - before.retunes) / BENCH_SWEEPS);
+  printf(" sweep_adc_samples=%u", (simCount.adcSamples - before.adcSamples) / BENCH_SWEEPS);
+  printf(" sweep_display_bytes=%u", (simCount.displayBytes - before.displayBytes) / BENCH_SWEEPS);
+
+  // The same for the waterfall, once its empty screen is drawn
+  sweepTarget = spectrumSweeps() + 1;
+  waterfallScanner(FREQUENCY_MIN);
+  if (!runWhile(sweeping))
+    goto timeout;
+  before = simCount;
+  sweepTarget += BENCH_SWEEPS;
+  if (!runWhile(sweeping))
+    goto timeout;
+  scanCancel();
+  printf(" waterfall_display_bytes=%u", (simCount.displayBytes - before.displayBytes) / BENCH_SWEEPS);
+
+  if (!measureLocks(false, &cold) || !measureLocks(true, &warm))
+    goto timeout;
+  printf(" cold_lock_ms=%.1f cold_locks=%u/%u cold_error_mhz=%.2f", cold.timeMs, cold.good, BENCH_STARTS, cold.errorMhz);
+  printf(" warm_lock_ms=%.1f warm_locks=%u/%u warm_error_mhz=%.2f", warm.timeMs, warm.good, BENCH_STARTS, warm.errorMhz);
+#ifdef SH1106_PAGE_BUFFER
+  uint8_t listItems, listChars;
+  display.listUsage(&listItems, &listChars);
+  printf(" list_items=%u/%u list_chars=%u/%u", listItems, SH1106_LIST_ITEMS, listChars, SH1106_LIST_CHARS);
+#endif
+  printf("\n");
+#ifdef PROFILE_PHASES
+  printProfile();
+#endif
+  return 0;
+
+timeout:
+  printf("scenario=%s timeout\n", name);
+  return 1;
+}
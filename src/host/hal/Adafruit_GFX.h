@@ -0,0 +1,49 @@
+// Host replacement for the Adafruit GFX library. Implements the subset used by
+// CYCLOP+ with the classic 5x7 font, so the simulated screen can be read.
+#ifndef _ADAFRUIT_GFX_H
+#define _ADAFRUIT_GFX_H
+
+#include "Arduino.h"
+
+class Adafruit_GFX : public Print
+{
+  public:
+    Adafruit_GFX( int16_t w, int16_t h );
+
+    virtual void drawPixel( int16_t x, int16_t y, uint16_t color ) = 0;
+    virtual void drawFastVLine( int16_t x, int16_t y, int16_t h, uint16_t color );
+    virtual void drawFastHLine( int16_t x, int16_t y, int16_t w, uint16_t color );
+    virtual void fillRect( int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color );
+    virtual void fillScreen( uint16_t color );
+    virtual void invertDisplay( uint8_t i ) { (void)i; }
+
+    void drawLine( int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color );
+    void drawRect( int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color );
+    void drawCircle( int16_t x0, int16_t y0, int16_t r, uint16_t color );
+    void drawChar( int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size );
+
+    void setCursor( int16_t x, int16_t y ) { cursor_x = x; cursor_y = y; }
+    void setTextColor( uint16_t c ) { textcolor = textbgcolor = c; }
+    void setTextColor( uint16_t c, uint16_t bg ) { textcolor = c; textbgcolor = bg; }
+    void setTextSize( uint8_t s ) { textsize = (s > 0) ? s : 1; }
+    void setTextWrap( boolean w ) { wrap = w; }
+    void setRotation( uint8_t r );
+
+    uint8_t getRotation( void ) const { return rotation; }
+    int16_t width( void ) const { return _width; }
+    int16_t height( void ) const { return _height; }
+    int16_t getCursorX( void ) const { return cursor_x; }
+    int16_t getCursorY( void ) const { return cursor_y; }
+
+    virtual size_t write( uint8_t c );
+    using Print::write;
+
+  protected:
+    const int16_t WIDTH, HEIGHT;
+    int16_t  _width, _height, cursor_x, cursor_y;
+    uint16_t textcolor, textbgcolor;
+    uint8_t  textsize, rotation;
+    boolean  wrap;
+};
+
+#endif // _ADAFRUIT_GFX_H
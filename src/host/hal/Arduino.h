@@ -0,0 +1,142 @@
+/*******************************************************************************
+  Host replacement for the Arduino core. Pins, time and the analog inputs are
+  routed to the simulator in sim.cpp, so the sketch runs against virtual time.
+  Only the parts of the core used by CYCLOP+ and its libraries are provided.
+
+  The MIT License (MIT)
+
+  Copyright (c) 2017 Kjell Kernen (Dvogonen)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+********************************************************************************/
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <avr/pgmspace.h>
+
+#define F_CPU         8000000L   // Arduino Pro Mini 3.3V
+
+typedef bool     boolean;
+typedef uint8_t  byte;
+
+#define HIGH          1
+#define LOW           0
+#define INPUT         0
+#define OUTPUT        1
+#define INPUT_PULLUP  2
+#define CHANGE        1
+#define FALLING       2
+#define RISING        3
+
+#define DEC           10
+#define HEX           16
+#define BIN           2
+
+#define A0            14
+#define A1            15
+#define A2            16
+#define A3            17
+#define A4            18
+#define A5            19
+#define A6            20
+#define A7            21
+#define SDA           18
+#define SCL           19
+#define LED_BUILTIN   13
+
+#define _BV(bit)      (1 << (bit))
+
+// Register touched by the Wire path of the display driver. The simulated
+// I2C bus derives its clock from it.
+extern volatile uint8_t TWBR;
+
+// Port access used by the SPI path of the display driver, goes nowhere
+extern volatile uint8_t simDummyPort;
+#define digitalPinToPort(pin)       (0)
+#define digitalPinToBitMask(pin)    ((uint8_t)_BV((pin) & 7))
+#define portOutputRegister(port)    (&simDummyPort)
+
+inline void cli( void ) {}
+inline void sei( void ) {}
+inline void noInterrupts( void ) {}
+inline void interrupts( void ) {}
+
+void     pinMode( uint8_t pin, uint8_t mode );
+void     digitalWrite( uint8_t pin, uint8_t value );
+int      digitalRead( uint8_t pin );
+int      analogRead( uint8_t pin );
+void     analogWrite( uint8_t pin, int value );
+uint32_t millis( void );
+uint32_t micros( void );
+void     delay( uint32_t ms );
+void     delayMicroseconds( unsigned int us );
+long     random( long max );
+long     random( long min, long max );
+void     randomSeed( unsigned long seed );
+
+//******************************************************************************
+//* Print and Serial
+
+class __FlashStringHelper;
+#define F(s)          (reinterpret_cast<const __FlashStringHelper *>(s))
+
+class Print
+{
+  public:
+    virtual ~Print() {}
+    virtual size_t write( uint8_t c ) = 0;
+    virtual size_t write( const uint8_t *buffer, size_t size );
+    size_t write( const char *s ) { return write((const uint8_t *)s, strlen(s)); }
+
+    size_t print( const __FlashStringHelper *s );
+    size_t print( const char *s );
+    size_t print( char c );
+    size_t print( unsigned char n, int base = DEC );
+    size_t print( int n, int base = DEC );
+    size_t print( unsigned int n, int base = DEC );
+    size_t print( long n, int base = DEC );
+    size_t print( unsigned long n, int base = DEC );
+    size_t print( double n, int digits = 2 );
+
+    size_t println( void );
+    template <typename T> size_t println( T value ) { size_t n = print(value); return n + println(); }
+    template <typename T> size_t println( T value, int format ) { size_t n = print(value, format); return n + println(); }
+
+  private:
+    size_t printNumber( unsigned long n, uint8_t base );
+};
+
+class HardwareSerial : public Print
+{
+  public:
+    void   begin( unsigned long baud );
+    void   end( void ) {}
+    void   flush( void );
+    int    availableForWrite( void );
+    size_t write( uint8_t c );
+    using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+#endif // Arduino_h
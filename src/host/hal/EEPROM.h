@@ -0,0 +1,20 @@
+// Host replacement for the EEPROM library, 1 KB like the ATmega328
+#ifndef EEPROM_h
+#define EEPROM_h
+
+#include "Arduino.h"
+
+#define EEPROM_SIZE   1024
+
+class EEPROMClass
+{
+  public:
+    uint8_t  read( int address );
+    void     write( int address, uint8_t value );
+    void     update( int address, uint8_t value );
+    uint16_t length( void ) { return EEPROM_SIZE; }
+};
+
+extern EEPROMClass EEPROM;
+
+#endif // EEPROM_h
@@ -0,0 +1,20 @@
+// Host replacement for the SPI library. The display is simulated on I2C,
+// the SPI path of the driver only has to compile.
+#ifndef SPI_h
+#define SPI_h
+
+#include "Arduino.h"
+
+#define SPI_CLOCK_DIV2  4
+
+class SPIClass
+{
+  public:
+    void    begin( void ) {}
+    void    setClockDivider( uint8_t divider ) { (void)divider; }
+    uint8_t transfer( uint8_t data ) { (void)data; return 0; }
+};
+
+extern SPIClass SPI;
+
+#endif // SPI_h
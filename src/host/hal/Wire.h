@@ -0,0 +1,28 @@
+// Host replacement for the Wire library. Transmissions are timed on the
+// virtual clock and handed to the simulated display.
+#ifndef Wire_h
+#define Wire_h
+
+#include "Arduino.h"
+
+#define BUFFER_LENGTH 32
+
+class TwoWire : public Print
+{
+  public:
+    void    begin( void );
+    void    setClock( uint32_t frequency );
+    void    beginTransmission( uint8_t address );
+    uint8_t endTransmission( bool stop = true );
+    size_t  write( uint8_t data );
+    using Print::write;
+
+  private:
+    uint8_t txAddress;
+    uint8_t txBuffer[BUFFER_LENGTH];
+    uint8_t txLength;
+};
+
+extern TwoWire Wire;
+
+#endif // Wire_h
@@ -0,0 +1,118 @@
+// Host replacement for the Adafruit GFX library, see Adafruit_GFX.h
+#include "Adafruit_GFX.h"
+
+// The 5x7 font, in the layout of the library
+#include "glcdfont.c"
+
+Adafruit_GFX::Adafruit_GFX( int16_t w, int16_t h ) : WIDTH(w), HEIGHT(h)
+{
+  _width = w;
+  _height = h;
+  cursor_x = cursor_y = 0;
+  textcolor = textbgcolor = 0xFFFF;
+  textsize = 1;
+  rotation = 0;
+  wrap = true;
+}
+
+void Adafruit_GFX::setRotation( uint8_t r )
+{
+  rotation = r & 3;
+  _width = (rotation & 1) ? HEIGHT : WIDTH;
+  _height = (rotation & 1) ? WIDTH : HEIGHT;
+}
+
+void Adafruit_GFX::drawFastVLine( int16_t x, int16_t y, int16_t h, uint16_t color )
+{
+  drawLine(x, y, x, y + h - 1, color);
+}
+
+void Adafruit_GFX::drawFastHLine( int16_t x, int16_t y, int16_t w, uint16_t color )
+{
+  drawLine(x, y, x + w - 1, y, color);
+}
+
+void Adafruit_GFX::fillRect( int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color )
+{
+  for (int16_t i = x; i < x + w; i++)
+    drawFastVLine(i, y, h, color);
+}
+
+void Adafruit_GFX::fillScreen( uint16_t color )
+{
+  fillRect(0, 0, _width, _height, color);
+}
+
+void Adafruit_GFX::drawLine( int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color )
+{
+  int16_t dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+  int16_t dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+  int16_t err = dx + dy;
+
+  for (;;) {
+    drawPixel(x0, y0, color);
+    if (x0 == x1 && y0 == y1)
+      break;
+    int16_t e2 = 2 * err;
+    if (e2 >= dy) { err += dy; x0 += sx; }
+    if (e2 <= dx) { err += dx; y0 += sy; }
+  }
+}
+
+void Adafruit_GFX::drawRect( int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color )
+{
+  drawFastHLine(x, y, w, color);
+  drawFastHLine(x, y + h - 1, w, color);
+  drawFastVLine(x, y, h, color);
+  drawFastVLine(x + w - 1, y, h, color);
+}
+
+void Adafruit_GFX::drawCircle( int16_t x0, int16_t y0, int16_t r, uint16_t color )
+{
+  int16_t x = r, y = 0, err = 1 - r;
+
+  while (x >= y) {
+    drawPixel(x0 + x, y0 + y, color); drawPixel(x0 - x, y0 + y, color);
+    drawPixel(x0 + x, y0 - y, color); drawPixel(x0 - x, y0 - y, color);
+    drawPixel(x0 + y, y0 + x, color); drawPixel(x0 - y, y0 + x, color);
+    drawPixel(x0 + y, y0 - x, color); drawPixel(x0 - y, y0 - x, color);
+    y++;
+    if (err < 0)
+      err += 2 * y + 1;
+    else
+      err += 2 * (y - --x) + 1;
+  }
+}
+
+void Adafruit_GFX::drawChar( int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size )
+{
+  for (int8_t i = 0; i < 6; i++) {
+    uint8_t line = (i < 5 && c < 0x80) ? pgm_read_byte(&font[c * 5 + i]) : 0;
+    for (int8_t j = 0; j < 8; j++, line >>= 1) {
+      if (!(line & 1) && bg == color)
+        continue;
+      uint16_t pixel = (line & 1) ? color : bg;
+      if (size == 1)
+        drawPixel(x + i, y + j, pixel);
+      else
+        fillRect(x + i * size, y + j * size, size, size, pixel);
+    }
+  }
+}
+
+size_t Adafruit_GFX::write( uint8_t c )
+{
+  if (c == '\n') {
+    cursor_y += textsize * 8;
+    cursor_x = 0;
+  }
+  else if (c != '\r') {
+    if (wrap && (cursor_x + textsize * 6) > _width) {
+      cursor_x = 0;
+      cursor_y += textsize * 8;
+    }
+    drawChar(cursor_x, cursor_y, c, textcolor, textbgcolor, textsize);
+    cursor_x += textsize * 6;
+  }
+  return 1;
+}
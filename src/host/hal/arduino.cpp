@@ -0,0 +1,191 @@
+// Host replacement for the Arduino core, see Arduino.h
+#include <stdio.h>
+
+#include "Arduino.h"
+#include "SPI.h"
+#include "hosttimer.h"
+#include "sim.h"
+
+HardwareSerial Serial;
+SPIClass SPI;
+
+static uint32_t randomState = 1;
+
+void pinMode( uint8_t pin, uint8_t mode )
+{
+  simPinMode(pin, mode);
+  simAdvance(SIM_PIN_US * 1000ULL);
+}
+
+void digitalWrite( uint8_t pin, uint8_t value )
+{
+  simPinWrite(pin, value);
+  simAdvance(SIM_PIN_US * 1000ULL);
+}
+
+int digitalRead( uint8_t pin )
+{
+  simAdvance(SIM_PIN_US * 1000ULL);
+  return simPinRead(pin);
+}
+
+int analogRead( uint8_t pin )
+{
+  return simAnalogRead(pin);
+}
+
+void analogWrite( uint8_t pin, int value )
+{
+  simPinOutput(pin, value);
+  simAdvance(SIM_PIN_US * 1000ULL);
+}
+
+uint32_t millis( void )
+{
+  simAdvance(SIM_CLOCK_US * 1000ULL);
+  return (uint32_t)(simNanos() / 1000000ULL);
+}
+
+uint32_t micros( void )
+{
+  simAdvance(SIM_CLOCK_US * 1000ULL);
+  return (uint32_t)(simNanos() / 1000ULL);
+}
+
+void delay( uint32_t ms )
+{
+  simAdvance(ms * 1000000ULL);
+}
+
+void delayMicroseconds( unsigned int us )
+{
+  simAdvance(us * 1000ULL);
+}
+
+long random( long max )
+{
+  // Park-Miller, like the avr-libc random()
+  randomState = (uint32_t)(((uint64_t)randomState * 16807) % 2147483647);
+  return max > 0 ? (long)(randomState % max) : 0;
+}
+
+long random( long min, long max )
+{
+  return min >= max ? min : min + random(max - min);
+}
+
+void randomSeed( unsigned long seed )
+{
+  if (seed)
+    randomState = seed;
+}
+
+void hostTimerAttach( void (*handler)(void), uint32_t periodUs )
+{
+  simAttachTimer(handler, periodUs * 1000ULL);
+}
+
+//******************************************************************************
+//* Print
+
+size_t Print::write( const uint8_t *buffer, size_t size )
+{
+  size_t n = 0;
+  while (size--)
+    n += write(*buffer++);
+  return n;
+}
+
+size_t Print::print( const __FlashStringHelper *s )
+{
+  return print(reinterpret_cast<const char *>(s));
+}
+
+size_t Print::print( const char *s )
+{
+  return write(s);
+}
+
+size_t Print::print( char c )
+{
+  return write((uint8_t)c);
+}
+
+size_t Print::print( unsigned char n, int base )
+{
+  return printNumber(n, base);
+}
+
+size_t Print::print( int n, int base )
+{
+  return print((long)n, base);
+}
+
+size_t Print::print( unsigned int n, int base )
+{
+  return printNumber(n, base);
+}
+
+size_t Print::print( long n, int base )
+{
+  if (n < 0 && base == DEC)
+    return print('-') + printNumber(-(unsigned long)n, base);
+  return printNumber(n, base);
+}
+
+size_t Print::print( unsigned long n, int base )
+{
+  return printNumber(n, base);
+}
+
+size_t Print::print( double n, int digits )
+{
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%.*f", digits, n);
+  return write(buffer);
+}
+
+size_t Print::println( void )
+{
+  return write("\r\n");
+}
+
+size_t Print::printNumber( unsigned long n, uint8_t base )
+{
+  char buffer[8 * sizeof(long) + 1];
+  char *s = buffer + sizeof(buffer) - 1;
+
+  if (base < 2)
+    base = 10;
+  *s = 0;
+  do {
+    uint8_t digit = n % base;
+    *--s = digit < 10 ? '0' + digit : 'A' + digit - 10;
+    n /= base;
+  } while (n);
+  return write(s);
+}
+
+//******************************************************************************
+//* HardwareSerial
+
+void HardwareSerial::begin( unsigned long baud )
+{
+  simSerialBegin(baud);
+}
+
+void HardwareSerial::flush( void )
+{
+  simSerialFlush();
+}
+
+int HardwareSerial::availableForWrite( void )
+{
+  return simSerialAvailableForWrite();
+}
+
+size_t HardwareSerial::write( uint8_t c )
+{
+  simSerialWrite(c);
+  return 1;
+}
@@ -0,0 +1,21 @@
+// Host replacement for avr/pgmspace.h, flash and RAM share one address space
+#ifndef pgmspace_h
+#define pgmspace_h
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PGM_P                       const char *
+#define PSTR(s)                     (s)
+#define pgm_read_byte(addr)         (*(const uint8_t *)(addr))
+#define pgm_read_word(addr)         (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr)        (*(const uint32_t *)(addr))
+#define pgm_read_ptr(addr)          (*(void * const *)(addr))
+#define pgm_read_byte_near(addr)    pgm_read_byte(addr)
+#define pgm_read_word_near(addr)    pgm_read_word(addr)
+#define strcpy_P(dest, src)         strcpy((dest), (src))
+#define strlen_P(s)                 strlen(s)
+#define memcpy_P(dest, src, n)      memcpy((dest), (src), (n))
+
+#endif // pgmspace_h
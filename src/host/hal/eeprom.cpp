@@ -0,0 +1,21 @@
+// Host replacement for the EEPROM library, see EEPROM.h
+#include "EEPROM.h"
+#include "sim.h"
+
+EEPROMClass EEPROM;
+
+uint8_t EEPROMClass::read( int address )
+{
+  return simEepromRead(address);
+}
+
+void EEPROMClass::write( int address, uint8_t value )
+{
+  simEepromWrite(address, value);
+}
+
+void EEPROMClass::update( int address, uint8_t value )
+{
+  if (simEepromRead(address) != value)
+    simEepromWrite(address, value);
+}
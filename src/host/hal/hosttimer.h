@@ -0,0 +1,10 @@
+// Host stand-in for a periodic timer interrupt. The simulator calls the
+// handler every period of virtual time, like a compare match interrupt.
+#ifndef hosttimer_h
+#define hosttimer_h
+
+#include "Arduino.h"
+
+void hostTimerAttach( void (*handler)(void), uint32_t periodUs );
+
+#endif // hosttimer_h
@@ -0,0 +1,18 @@
+// Host replacement for util/crc16.h, only the CRC-8 used by the sketch
+#ifndef crc16_h
+#define crc16_h
+
+#include <stdint.h>
+
+// CRC-8 with polynomial 0x07, as in avr-libc
+static inline uint8_t _crc8_ccitt_update( uint8_t crc, uint8_t data )
+{
+  uint8_t i;
+
+  crc ^= data;
+  for (i = 0; i < 8; i++)
+    crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+  return crc;
+}
+
+#endif // crc16_h
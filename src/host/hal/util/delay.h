@@ -0,0 +1,4 @@
+// Host replacement for util/delay.h, use delay() and delayMicroseconds()
+#ifndef delay_h
+#define delay_h
+#endif // delay_h
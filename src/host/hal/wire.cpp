@@ -0,0 +1,38 @@
+// Host replacement for the Wire library, see Wire.h
+#include "Wire.h"
+#include "sim.h"
+
+TwoWire Wire;
+
+void TwoWire::begin( void )
+{
+  setClock(100000);
+  txLength = 0;
+}
+
+void TwoWire::setClock( uint32_t frequency )
+{
+  TWBR = ((F_CPU / frequency) - 16) / 2;
+}
+
+void TwoWire::beginTransmission( uint8_t address )
+{
+  txAddress = address;
+  txLength = 0;
+}
+
+uint8_t TwoWire::endTransmission( bool stop )
+{
+  (void)stop;
+  simI2cTransmit(txAddress, txBuffer, txLength);
+  txLength = 0;
+  return 0;
+}
+
+size_t TwoWire::write( uint8_t data )
+{
+  if (txLength >= BUFFER_LENGTH)
+    return 0;
+  txBuffer[txLength++] = data;
+  return 1;
+}
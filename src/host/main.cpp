@@ -0,0 +1,135 @@
+/*******************************************************************************
+  This file contains main() of the CYCLOP+ host simulator. It runs setup()
+  and loop() of the sketch against a scene for a given virtual time and
+  prints a report of what the hardware saw.
+
+  The MIT License (MIT)
+
+  Copyright (c) 2017 Kjell Kernen (Dvogonen)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+********************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "Arduino.h"
+#include "sim.h"
+#include "Adafruit_SH1106.h"
+#include "button.h"
+#include "scheduler.h"
+
+void setup( void );
+extern Adafruit_SH1106 display;
+extern uint8_t ledTask, batteryTask, alarmTask, saveTask, refreshTask, screenSaverTask;
+
+static const char *eepromPath = 0;
+static bool        printScreen = false;
+
+//******************************************************************************
+//* function: report
+//*         : prints the counters as key=value lines and ends the run
+//******************************************************************************
+static void report( void )
+{
+  simSerialFlush();
+  printf("time_ms=%.3f\n", simNanos() / 1e6);
+  printf("frequency=%u\n", simTunedFrequency());
+  printf("loops=%u\n", simCount.loops);
+  printf("retunes=%u\n", simCount.retunes);
+  printf("adc_samples=%u\n", simCount.adcSamples);
+  printf("i2c_bytes=%u\n", simCount.i2cBytes);
+  printf("display_bytes=%u\n", simCount.displayBytes);
+  printf("eeprom_writes=%u\n", simCount.eepromWrites);
+  printf("serial_bytes=%u\n", simCount.serialBytes);
+  printf("click_latency_ms=%u\n", buttonLatency());
+  printf("late_led_ms=%u\n", schedulerLateness(ledTask));
+  printf("late_battery_ms=%u\n", schedulerLateness(batteryTask));
+  printf("late_alarm_ms=%u\n", schedulerLateness(alarmTask));
+  printf("late_save_ms=%u\n", schedulerLateness(saveTask));
+  printf("late_refresh_ms=%u\n", schedulerLateness(refreshTask));
+  printf("late_saver_ms=%u\n", schedulerLateness(screenSaverTask));
+#ifdef SH1106_PAGE_BUFFER
+  uint8_t listItems, listChars;
+  display.listUsage(&listItems, &listChars);
+  printf("list_items=%u\n", listItems);
+  printf("list_chars=%u\n", listChars);
+#endif
+  if (printScreen)
+    simPrintScreen(stdout);
+  if (eepromPath)
+    simEepromSave(eepromPath);
+  fflush(stdout);
+  exit(0);
+}
+
+static void usage( const char *name )
+{
+  fprintf(stderr,
+          "usage: %s [-t ms] [-e eeprom.bin] [-o serial.out] [-s] [-v] [scene]\n"
+          "  -t ms   virtual time to run, default 10000\n"
+          "  -e      EEPROM image, loaded at start and saved at the end\n"
+          "  -o      file for the serial port output, default stderr, or none\n"
+          "          in a STREAM_SPECTRUM build as its frames are binary\n"
+          "  -s      print the display at the end\n"
+          "  -v      trace retunes and pin events on stderr\n", name);
+  exit(2);
+}
+
+int main( int argc, char *argv[] )
+{
+  double runMs = 10000;
+  int    option;
+
+#ifndef STREAM_SPECTRUM
+  simSerialOutput(stderr);
+#endif
+  while ((option = getopt(argc, argv, "t:e:o:sv")) != -1) {
+    switch (option) {
+      case 't':
+        runMs = atof(optarg);
+        break;
+      case 'e':
+        eepromPath = optarg;
+        break;
+      case 'o':
+        simSerialOutput(fopen(optarg, "wb"));
+        break;
+      case 's':
+        printScreen = true;
+        break;
+      case 'v':
+        simTrace(true);
+        break;
+      default:
+        usage(argv[0]);
+    }
+  }
+  if (optind < argc && !simLoadScene(argv[optind])) {
+    fprintf(stderr, "cannot load scene %s\n", argv[optind]);
+    return 1;
+  }
+  if (eepromPath)
+    simEepromLoad(eepromPath);
+
+  simRunUntil((uint64_t)(runMs * 1e6), report);
+  setup();
+  for (;;)
+    simStep();
+}
@@ -0,0 +1,643 @@
+/*******************************************************************************
+  This file contains the CYCLOP+ host simulator, see sim.h.
+
+  The MIT License (MIT)
+
+  Copyright (c) 2017 Kjell Kernen (Dvogonen)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+********************************************************************************/
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Arduino.h"
+#include "sim.h"
+#include "cyclop_plus.h"
+
+simCounters simCount;
+volatile uint8_t TWBR = 0;
+volatile uint8_t simDummyPort = 0;
+
+//******************************************************************************
+//* Virtual clock and scripted events
+
+struct simEvent {
+  uint64_t at;
+  uint8_t  pin;
+  uint8_t  level;
+};
+
+static uint64_t  now = 0;
+static uint64_t  endTime = UINT64_MAX;
+static void    (*endHandler)(void) = 0;
+static simEvent  events[SIM_MAX_EVENTS];
+static uint16_t  eventCount = 0;
+static uint16_t  eventNext = 0;
+static bool      inInterrupt = false;
+static void    (*timerHandler)(void) = 0;
+static uint64_t  timerPeriod = 0;
+static uint64_t  timerNext = 0;
+static bool      trace = false;
+
+static uint8_t   pinLevel[32];
+static uint8_t   pinModes[32];
+
+static void simSetLevel( uint8_t pin, uint8_t level );
+void loop( void );
+
+//******************************************************************************
+//* function: simNanos
+//******************************************************************************
+uint64_t simNanos( void )
+{
+  return now;
+}
+
+//******************************************************************************
+//* function: simAdvance
+//*         : moves the clock forward and applies the events and timer ticks
+//*         : that fall due, in the order of their time. The timer handler
+//*         : runs like an interrupt, events and ticks that fall due while it
+//*         : runs wait until it returns, like on the AVR.
+//******************************************************************************
+void simAdvance( uint64_t ns )
+{
+  uint64_t target = now + ns;
+
+  while (!inInterrupt) {
+    uint64_t eventAt = eventNext < eventCount ? events[eventNext].at : UINT64_MAX;
+    uint64_t tickAt = timerHandler ? timerNext : UINT64_MAX;
+
+    if (eventAt > target && tickAt > target)
+      break;
+    if (eventAt <= tickAt) {
+      simEvent *e = &events[eventNext++];
+      if (e->at > now)
+        now = e->at;
+      if (trace)
+        fprintf(stderr, "%10.3f ms pin %u %s\n", now / 1e6, e->pin, e->level ? "high" : "low");
+      simSetLevel(e->pin, e->level);
+    }
+    else {
+      if (tickAt > now)
+        now = tickAt;
+      timerNext += timerPeriod;
+      inInterrupt = true;
+      timerHandler();
+      inInterrupt = false;
+    }
+    if (target < now)
+      target = now;
+  }
+  now = target;
+
+  if (now >= endTime && endHandler) {
+    void (*handler)(void) = endHandler;
+    endHandler = 0;
+    handler();
+  }
+}
+
+//******************************************************************************
+//* function: simRunUntil
+//*         : the handler is called once the clock passes the given time,
+//*         : even from inside a blocking loop of the sketch
+//******************************************************************************
+void simRunUntil( uint64_t ns, void (*onEnd)(void) )
+{
+  endTime = ns;
+  endHandler = onEnd;
+}
+
+//******************************************************************************
+//* function: simStep
+//*         : runs one pass of loop() of the sketch
+//******************************************************************************
+void simStep( void )
+{
+  loop();
+  simCount.loops++;
+  simAdvance(SIM_LOOP_US * 1000ULL);
+}
+
+static void simAddEvent( uint64_t at, uint8_t pin, uint8_t level )
+{
+  uint16_t i;
+
+  if (eventCount >= SIM_MAX_EVENTS)
+    return;
+  // Keep the list sorted, scenes are short
+  for (i = eventCount; i > 0 && events[i - 1].at > at; i--)
+    events[i] = events[i - 1];
+  events[i].at = at;
+  events[i].pin = pin;
+  events[i].level = level;
+  eventCount++;
+}
+
+//******************************************************************************
+//* RTC6715 receiver
+//* Frames are shifted in on the rising clock edge while slave select is low,
+//* LSB first: 4 bits address, 1 bit read/write, 20 bits data.
+
+static simTransmitter transmitters[SIM_MAX_TRANSMITTERS];
+static uint8_t  transmitterCount = 0;
+static float    noiseFloor = 140;
+static float    noiseLevel = 3;
+static float    settleTau = 4e6;         // RSSI settling time constant, ns
+static float    batteryVolts = 12.0;
+static uint32_t noiseSeed = 1;
+
+static uint32_t rxRegister[16];
+static uint32_t rxFrame;
+static uint8_t  rxBits;
+static bool     rxSelected = false;
+static uint16_t rxFrequency = 0;
+static float    rxStartLevel = 0;
+static uint64_t rxTuneTime = 0;
+
+static float simRssiTarget( void )
+{
+  float level = 0;
+  uint8_t i;
+
+  for (i = 0; i < transmitterCount; i++) {
+    simTransmitter *t = &transmitters[i];
+    if (now < t->from || now >= t->to)
+      continue;
+    float offset = 2 * (rxFrequency - t->frequency) / t->bandwidth;
+    float received = t->power / (1 + offset * offset);
+    if (received > level)
+      level = received;
+  }
+  return noiseFloor + level;
+}
+
+static float simRssiLevel( void )
+{
+  float target = simRssiTarget();
+  return target + (rxStartLevel - target) * expf(-(float)(now - rxTuneTime) / settleTau);
+}
+
+static uint32_t simRandom( void )
+{
+  // xorshift32, the runs are repeatable for a given scene
+  noiseSeed ^= noiseSeed << 13;
+  noiseSeed ^= noiseSeed >> 17;
+  noiseSeed ^= noiseSeed << 5;
+  return noiseSeed;
+}
+
+static void simReceiverFrame( void )
+{
+  uint8_t  address = rxFrame & 0x0F;
+  uint32_t data = (rxFrame >> 5) & 0xFFFFF;
+
+  if (rxBits < 25 || !(rxFrame & 0x10))
+    return;
+  rxRegister[address] = data;
+  if (address != 0x01)
+    return;
+
+  // Register B: frequency = (N * 32 + A) * 2 + 479
+  rxStartLevel = simRssiLevel();
+  rxTuneTime = now;
+  rxFrequency = ((data >> 7) * 32 + (data & 0x7F)) * 2 + 479;
+  simCount.retunes++;
+  if (trace)
+    fprintf(stderr, "%10.3f ms tune %u MHz\n", now / 1e6, rxFrequency);
+}
+
+static void simReceiverPin( uint8_t pin, uint8_t level )
+{
+  if (pin == SLAVE_SELECT_PIN) {
+    if (!level && !rxSelected) {
+      rxFrame = 0;
+      rxBits = 0;
+    }
+    else if (level && rxSelected)
+      simReceiverFrame();
+    rxSelected = !level;
+  }
+  else if (pin == SPI_CLOCK_PIN && level && !pinLevel[SPI_CLOCK_PIN] && rxSelected) {
+    if (rxBits < 32)
+      rxFrame |= (uint32_t)pinLevel[SPI_DATA_PIN] << rxBits;
+    rxBits++;
+    // Read frames: the receiver drives the data line after the header
+    if (rxBits >= 5 && !(rxFrame & 0x10) && pinModes[SPI_DATA_PIN] != OUTPUT)
+      pinLevel[SPI_DATA_PIN] = (rxRegister[rxFrame & 0x0F] >> (rxBits - 5)) & 1;
+  }
+}
+
+//******************************************************************************
+//* function: simTunedFrequency
+//******************************************************************************
+uint16_t simTunedFrequency( void )
+{
+  return rxFrequency;
+}
+
+//******************************************************************************
+//* function: simTransmitterCount, simTransmitterAt, simNoiseFloor
+//*         : the scene as loaded, for checking scan results
+//******************************************************************************
+uint8_t simTransmitterCount( void )
+{
+  return transmitterCount;
+}
+
+const simTransmitter *simTransmitterAt( uint8_t index )
+{
+  return &transmitters[index];
+}
+
+float simNoiseFloor( void )
+{
+  return noiseFloor;
+}
+
+//******************************************************************************
+//* function: simTrace
+//*         : prints retunes and button events on stderr
+//******************************************************************************
+void simTrace( bool on )
+{
+  trace = on;
+}
+
+//******************************************************************************
+//* Pins
+
+static void simSetLevel( uint8_t pin, uint8_t level )
+{
+  pinLevel[pin] = level;
+}
+
+void simPinMode( uint8_t pin, uint8_t mode )
+{
+  pinModes[pin & 31] = mode;
+  if (mode == INPUT_PULLUP)
+    pinLevel[pin & 31] = HIGH;
+}
+
+void simPinWrite( uint8_t pin, uint8_t value )
+{
+  pin &= 31;
+  value = value ? HIGH : LOW;
+  simReceiverPin(pin, value);
+  pinLevel[pin] = value;
+}
+
+uint8_t simPinRead( uint8_t pin )
+{
+  return pinLevel[pin & 31];
+}
+
+void simPinOutput( uint8_t pin, int value )
+{
+  pinLevel[pin & 31] = value ? HIGH : LOW;
+}
+
+//******************************************************************************
+//* function: simAttachTimer
+//*         : calls the handler every period from now on, 0 stops the timer
+//******************************************************************************
+void simAttachTimer( void (*handler)(void), uint64_t periodNs )
+{
+  timerHandler = handler;
+  timerPeriod = periodNs;
+  timerNext = now + periodNs;
+}
+
+//******************************************************************************
+//* function: simAnalogRead
+//*         : RSSI follows the tuned frequency with a first order settling,
+//*         : the battery input uses the voltages measured on the goggles
+//******************************************************************************
+uint16_t simAnalogRead( uint8_t pin )
+{
+  static const float volts[] = { 7.2, 8.4, 10.8, 12.6 };
+  static const float counts[] = { 359, 411, 546, 639 };
+  float value = 0;
+  uint8_t i;
+
+  simCount.adcSamples++;
+  if (pin == RSSI_PIN) {
+    value = simRssiLevel();
+    if (noiseLevel > 0)
+      value += ((simRandom() % 2001) / 1000.0f - 1.0f) * noiseLevel;
+  }
+  else if (pin == VOLTAGE_METER_PIN) {
+    for (i = 1; i < 3 && batteryVolts > volts[i]; i++)
+      ;
+    value = counts[i - 1] + (batteryVolts - volts[i - 1]) * (counts[i] - counts[i - 1]) / (volts[i] - volts[i - 1]);
+  }
+  if (value < 0)
+    value = 0;
+  if (value > 1023)
+    value = 1023;
+  return (uint16_t)(value + 0.5f);
+}
+
+//******************************************************************************
+//* function: simAddPress
+//*         : adds the edges of a button press. A bouncing contact toggles
+//*         : every 0.4 ms until it settles.
+//******************************************************************************
+static void simAddPress( float at, float hold, float bounce )
+{
+  float t;
+
+  simAddEvent((uint64_t)(at * 1e6), BUTTON_PIN, BUTTON_PRESSED);
+  simAddEvent((uint64_t)((at + hold) * 1e6), BUTTON_PIN, !BUTTON_PRESSED);
+  for (t = 0.4f; t + 0.4f < bounce; t += 0.8f) {
+    simAddEvent((uint64_t)((at + t) * 1e6), BUTTON_PIN, !BUTTON_PRESSED);
+    simAddEvent((uint64_t)((at + t + 0.4f) * 1e6), BUTTON_PIN, BUTTON_PRESSED);
+    simAddEvent((uint64_t)((at + hold + t) * 1e6), BUTTON_PIN, BUTTON_PRESSED);
+    simAddEvent((uint64_t)((at + hold + t + 0.4f) * 1e6), BUTTON_PIN, !BUTTON_PRESSED);
+  }
+}
+
+//******************************************************************************
+//* function: simLoadScene
+//*         : reads an RF scene, one statement per line, # starts a comment
+//*         :   floor <rssi>                  noise floor in ADC counts
+//*         :   noise <counts>                peak noise added to each sample
+//*         :   settle <ms>                   RSSI settling time constant
+//*         :   battery <volts>               battery voltage
+//*         :   seed <number>                 noise generator seed
+//*         :   tx <MHz> <power> <bandwidth> [<from ms> [<to ms>]]
+//*         :   press <at ms> <hold ms> [<bounce ms>]
+//*         :                                 button press, the contacts
+//*         :                                 chatter for bounce ms at each edge
+//******************************************************************************
+bool simLoadScene( const char *path )
+{
+  char  line[160];
+  FILE *f = fopen(path, "r");
+
+  if (!f)
+    return false;
+  while (fgets(line, sizeof(line), f)) {
+    char  word[16];
+    float a, b, c, d, e;
+    char *comment = strchr(line, '#');
+    if (comment)
+      *comment = 0;
+    int n = sscanf(line, "%15s %f %f %f %f %f", word, &a, &b, &c, &d, &e);
+    if (n <= 0)
+      continue;
+    if (!strcmp(word, "floor") && n >= 2)
+      noiseFloor = a;
+    else if (!strcmp(word, "noise") && n >= 2)
+      noiseLevel = a;
+    else if (!strcmp(word, "settle") && n >= 2)
+      settleTau = a * 1e6;
+    else if (!strcmp(word, "battery") && n >= 2)
+      batteryVolts = a;
+    else if (!strcmp(word, "seed") && n >= 2)
+      noiseSeed = (uint32_t)a ? (uint32_t)a : 1;
+    else if (!strcmp(word, "tx") && n >= 4 && transmitterCount < SIM_MAX_TRANSMITTERS) {
+      simTransmitter *t = &transmitters[transmitterCount++];
+      t->frequency = a;
+      t->power = b;
+      t->bandwidth = c;
+      t->from = n >= 5 ? (uint64_t)(d * 1e6) : 0;
+      t->to = n >= 6 ? (uint64_t)(e * 1e6) : UINT64_MAX;
+    }
+    else if (!strcmp(word, "press") && n >= 3) {
+      simAddPress(a, b, n >= 4 ? c : 0);
+    }
+    else {
+      fprintf(stderr, "%s: cannot parse: %s", path, line);
+      fclose(f);
+      return false;
+    }
+  }
+  fclose(f);
+  return true;
+}
+
+//******************************************************************************
+//* SH1106 display
+//* Control byte 0x00 starts a command stream, 0x40 a data stream. Commands
+//* with an argument take it from the following command byte, which may come
+//* in the next transmission.
+
+static uint8_t displayRam[8][132];
+static uint8_t displayPage = 0;
+static uint8_t displayColumn = 0;
+static uint8_t displayStartLine = 0;
+static uint8_t displayContrast = 0x80;
+static bool    displayOn = false;
+static uint8_t displayArgument = 0;
+
+static void simDisplayCommand( uint8_t c )
+{
+  if (displayArgument) {
+    if (displayArgument == 0x81)
+      displayContrast = c;
+    displayArgument = 0;
+    return;
+  }
+  switch (c) {
+    case 0x81: case 0xA8: case 0xD3: case 0xD5: case 0xD9: case 0xDA:
+    case 0xDB: case 0x8D: case 0xAD: case 0x20:
+      displayArgument = c;
+      break;
+    case 0xAE: displayOn = false; break;
+    case 0xAF: displayOn = true; break;
+    default:
+      if (c >= 0xB0 && c <= 0xB7)
+        displayPage = c & 0x07;
+      else if (c <= 0x0F)
+        displayColumn = (displayColumn & 0xF0) | c;
+      else if (c <= 0x1F)
+        displayColumn = (displayColumn & 0x0F) | ((c & 0x0F) << 4);
+      else if (c >= 0x40 && c <= 0x7F)
+        displayStartLine = c & 0x3F;
+      break;
+  }
+}
+
+static void simDisplayTransmit( const uint8_t *data, uint8_t length )
+{
+  uint8_t control;
+  uint8_t i;
+
+  if (!length)
+    return;
+  control = data[0];
+  for (i = 1; i < length; i++) {
+    if (control & 0x40) {
+      if (displayColumn < 132)
+        displayRam[displayPage][displayColumn++] = data[i];
+      simCount.displayBytes++;
+    }
+    else
+      simDisplayCommand(data[i]);
+  }
+}
+
+//******************************************************************************
+//* function: simPrintScreen
+//*         : prints the visible display as text, # for a lit pixel
+//******************************************************************************
+void simPrintScreen( FILE *f )
+{
+  uint8_t x, y, line;
+
+  fprintf(f, "display %s contrast %u\n", displayOn ? "on" : "off", displayContrast);
+  for (y = 0; y < 64; y++) {
+    line = (y + displayStartLine) & 63;
+    for (x = 0; x < 128; x++)
+      fputc((displayRam[line / 8][x] >> (line & 7)) & 1 ? '#' : '.', f);
+    fputc('\n', f);
+  }
+}
+
+//******************************************************************************
+//* function: simCopyScreen
+//*         : copies the visible 128 columns of the 8 display RAM pages
+//******************************************************************************
+void simCopyScreen( uint8_t ram[8][128] )
+{
+  uint8_t page;
+
+  for (page = 0; page < 8; page++)
+    memcpy(ram[page], displayRam[page], 128);
+}
+
+//******************************************************************************
+//* function: simI2cTransmit
+//*         : one transmission with start, address, data and stop. The bus
+//*         : clock follows TWBR like the TWI hardware, prescaler 1.
+//******************************************************************************
+void simI2cTransmit( uint8_t address, const uint8_t *data, uint8_t length )
+{
+  uint32_t scl = F_CPU / (16 + 2 * (uint32_t)TWBR);
+  uint32_t bits = (1 + length) * 9 + 2;
+
+  simCount.i2cBytes += 1 + length;
+  if (address == OLED_I2C_ADR)
+    simDisplayTransmit(data, length);
+  simAdvance((uint64_t)bits * 1000000000ULL / scl);
+}
+
+//******************************************************************************
+//* Serial port
+//* 64 byte transmit buffer drained at the baud rate, writes block when full.
+//* The output is dropped unless simSerialOutput gave a file for it
+
+static uint64_t serialByteTime = 0;
+static uint64_t serialIdle = 0;
+static FILE    *serialFile = 0;
+
+static int simSerialPending( void )
+{
+  if (!serialByteTime || serialIdle <= now)
+    return 0;
+  return (int)((serialIdle - now + serialByteTime - 1) / serialByteTime);
+}
+
+void simSerialBegin( uint32_t baud )
+{
+  serialByteTime = 10000000000ULL / baud;
+}
+
+void simSerialWrite( uint8_t c )
+{
+  if (simSerialPending() >= 64)
+    simAdvance(serialIdle - now - 63 * serialByteTime);
+  serialIdle = (serialIdle > now ? serialIdle : now) + serialByteTime;
+  simCount.serialBytes++;
+  if (serialFile)
+    fputc(c, serialFile);
+}
+
+int simSerialAvailableForWrite( void )
+{
+  return 63 - simSerialPending();
+}
+
+void simSerialFlush( void )
+{
+  if (serialIdle > now)
+    simAdvance(serialIdle - now);
+  if (serialFile)
+    fflush(serialFile);
+}
+
+void simSerialOutput( FILE *f )
+{
+  serialFile = f;
+}
+
+//******************************************************************************
+//* EEPROM
+
+static uint8_t eeprom[1024];
+static bool    eepromErased = false;
+
+static void simEepromErase( void )
+{
+  if (!eepromErased) {
+    memset(eeprom, 0xFF, sizeof(eeprom));
+    eepromErased = true;
+  }
+}
+
+uint8_t simEepromRead( uint16_t address )
+{
+  simEepromErase();
+  return eeprom[address & 1023];
+}
+
+void simEepromWrite( uint16_t address, uint8_t value )
+{
+  simEepromErase();
+  eeprom[address & 1023] = value;
+  simCount.eepromWrites++;
+  simAdvance(SIM_EEPROM_US * 1000ULL);
+}
+
+bool simEepromLoad( const char *path )
+{
+  FILE *f = fopen(path, "rb");
+
+  simEepromErase();
+  if (!f)
+    return false;
+  fread(eeprom, 1, sizeof(eeprom), f);
+  fclose(f);
+  return true;
+}
+
+bool simEepromSave( const char *path )
+{
+  FILE *f = fopen(path, "wb");
+
+  if (!f)
+    return false;
+  simEepromErase();
+  fwrite(eeprom, 1, sizeof(eeprom), f);
+  fclose(f);
+  return true;
+}
@@ -0,0 +1,105 @@
+/*******************************************************************************
+  This is the header file for the CYCLOP+ host simulator. It keeps a virtual
+  clock and models the hardware around the ATmega328: the RTC6715 receiver
+  behind the bit-banged SPI pins, the RSSI and battery inputs, the button,
+  the SH1106 display on I2C and the EEPROM.
+
+  The RF environment is read from a scene file, see scenes/example.scene.
+
+  The MIT License (MIT)
+
+  Copyright (c) 2017 Kjell Kernen (Dvogonen)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+********************************************************************************/
+#ifndef sim_h
+#define sim_h
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Virtual time charged for hardware access, in microseconds. Code run
+// between those calls is not timed, SIM_LOOP_US stands in for it.
+// analogRead() is free: on the goggles the conversions run from the ADC
+// interrupt, the host build of the sampler replays them with analogRead().
+#define SIM_PIN_US        6       // digitalWrite(), digitalRead(), pinMode()
+#define SIM_CLOCK_US      2       // millis(), micros()
+#define SIM_EEPROM_US     3400    // EEPROM write cycle
+#define SIM_LOOP_US       50      // One pass of loop()
+
+#define SIM_MAX_TRANSMITTERS  32
+#define SIM_MAX_EVENTS        512
+
+struct simCounters {
+  uint32_t loops;                 // Passes of loop()
+  uint32_t retunes;               // Frames written to synthesizer register B
+  uint32_t adcSamples;            // Calls to analogRead()
+  uint32_t i2cBytes;              // Bytes on the I2C bus, address included
+  uint32_t displayBytes;          // Bytes written to display RAM
+  uint32_t eepromWrites;
+  uint32_t serialBytes;
+};
+
+struct simTransmitter {
+  float    frequency;
+  float    power;       // RSSI counts above the noise floor
+  float    bandwidth;   // MHz between the half power points
+  uint64_t from;        // Active window, ns
+  uint64_t to;
+};
+
+extern simCounters simCount;
+
+// Virtual clock
+uint64_t simNanos( void );
+void     simAdvance( uint64_t ns );
+void     simRunUntil( uint64_t ns, void (*onEnd)(void) );
+void     simStep( void );
+
+// Pins and interrupts
+void     simPinMode( uint8_t pin, uint8_t mode );
+void     simPinWrite( uint8_t pin, uint8_t value );
+uint8_t  simPinRead( uint8_t pin );
+void     simPinOutput( uint8_t pin, int value );
+void     simAttachTimer( void (*handler)(void), uint64_t periodNs );
+uint16_t simAnalogRead( uint8_t pin );
+
+// Receiver and RF scene
+bool     simLoadScene( const char *path );
+uint16_t simTunedFrequency( void );
+uint8_t  simTransmitterCount( void );
+const simTransmitter *simTransmitterAt( uint8_t index );
+float    simNoiseFloor( void );
+void     simTrace( bool on );
+
+// Peripherals
+void     simI2cTransmit( uint8_t address, const uint8_t *data, uint8_t length );
+void     simSerialBegin( uint32_t baud );
+void     simSerialWrite( uint8_t c );
+int      simSerialAvailableForWrite( void );
+void     simSerialFlush( void );
+void     simSerialOutput( FILE *f );
+uint8_t  simEepromRead( uint16_t address );
+void     simEepromWrite( uint16_t address, uint8_t value );
+bool     simEepromLoad( const char *path );
+bool     simEepromSave( const char *path );
+void     simPrintScreen( FILE *f );
+void     simCopyScreen( uint8_t ram[8][128] );
+
+#endif // sim_h
@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+"""Decodes and plots the spectrum stream of CYCLOP+.
+
+Build the firmware with STREAM_SPECTRUM defined in stream.h and start the
+graphic scanner. The samples are read from a serial port (needs pyserial)
+or from a file, such as the serial output of the host simulator:
+
+  spectrum_plot.py /dev/ttyUSB0           live plot, needs matplotlib
+  spectrum_plot.py -d sim.out             print frames as text
+
+The frame layout is described in src/cyclop_plus/stream.h.
+
+The MIT License (MIT)
+Copyright (c) 2017 Kjell Kernen (Dvogonen)
+See the LICENSE file for the full license text.
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+SYNC = 0xA5
+SWEEP = ord('S')
+SAMPLE = ord('R')
+SIZES = {SWEEP: 10, SAMPLE: 7}
+BAUD = 500000
+
+
+def crc8(data):
+    crc = 0
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+class Decoder:
+    """Splits a byte stream into frames, resynchronizing on bad checksums."""
+
+    def __init__(self):
+        self.buffer = bytearray()
+        self.bad = 0
+
+    def feed(self, data):
+        self.buffer += data
+        frames = []
+        while True:
+            start = self.buffer.find(SYNC)
+            if start < 0:
+                self.buffer.clear()
+                break
+            del self.buffer[:start]
+            if len(self.buffer) < 2:
+                break
+            size = SIZES.get(self.buffer[1])
+            if size is None:
+                self.bad += 1
+                del self.buffer[:1]
+                continue
+            if len(self.buffer) < size:
+                break
+            frame = bytes(self.buffer[:size])
+            if crc8(frame[1:-1]) != frame[-1]:
+                self.bad += 1
+                del self.buffer[:1]
+                continue
+            del self.buffer[:size]
+            if frame[1] == SWEEP:
+                frames.append(('sweep',) + struct.unpack('<HHBH', frame[2:-1]))
+            else:
+                frames.append(('sample',) + struct.unpack('<HH', frame[2:-1]))
+        return frames
+
+
+def open_source(name):
+    if os.path.exists(name) and not name.startswith('/dev/'):
+        return open(name, 'rb').read
+    import serial
+    port = serial.Serial(name, BAUD, timeout=0.05)
+    return lambda size: port.read(size)
+
+
+def dump(read):
+    decoder = Decoder()
+    while True:
+        data = read(4096)
+        if not data:
+            break
+        for frame in decoder.feed(data):
+            if frame[0] == 'sweep':
+                print('sweep %u-%u MHz step %u dropped %u' % frame[1:])
+            else:
+                print('%u %u' % frame[1:])
+    print('bad frames %u' % decoder.bad, file=sys.stderr)
+
+
+def plot(read):
+    import matplotlib.pyplot as plt
+
+    decoder = Decoder()
+    current, peak = {}, {}
+    sweeps = dropped = 0
+    plt.ion()
+    figure, axes = plt.subplots()
+    line, = axes.plot([], [], label='current')
+    hold, = axes.plot([], [], label='peak hold')
+    axes.set_xlabel('MHz')
+    axes.set_ylabel('RSSI')
+    axes.set_ylim(0, 1023)
+    axes.legend(loc='upper right')
+    while plt.fignum_exists(figure.number):
+        data = read(4096)
+        for frame in decoder.feed(data):
+            if frame[0] == 'sweep':
+                axes.set_xlim(frame[1], frame[2])
+                sweeps += 1
+                dropped += frame[4]
+            else:
+                current[frame[1]] = frame[2]
+                peak[frame[1]] = max(frame[2], peak.get(frame[1], 0))
+        if current:
+            keys = sorted(current)
+            line.set_data(keys, [current[k] for k in keys])
+            hold.set_data(keys, [peak[k] for k in keys])
+            axes.set_title('sweeps %u  dropped %u  bad %u' % (sweeps, dropped, decoder.bad))
+        plt.pause(0.02)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('-d', '--dump', action='store_true', help='print frames instead of plotting')
+    parser.add_argument('source', help='serial port or file')
+    args = parser.parse_args()
+    read = open_source(args.source)
+    if args.dump:
+        dump(read)
+    else:
+        plot(read)
+
+
+if __name__ == '__main__':
+    main()